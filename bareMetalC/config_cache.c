@@ -0,0 +1,79 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+#define WIDE_DIM (2*DIM)
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t Narrow[DIM][DIM] row_align(1);
+  static elem_t Wide[DIM][WIDE_DIM] row_align(1);
+  static elem_t Out[2][DIM][DIM] row_align(1);
+
+  for (size_t i = 0; i < DIM; i++) {
+    for (size_t j = 0; j < DIM; j++)
+      Narrow[i][j] = (rand() % 64) - 32;
+    for (size_t j = 0; j < WIDE_DIM; j++)
+      Wide[i][j] = (rand() % 64) - 32;
+  }
+
+  // Only a CONFIG which changes its register should be issued
+  const size_t issued = matmul_config_cache.issued;
+  const size_t suppressed = matmul_config_cache.suppressed;
+
+  matmul_config_st(DIM*sizeof(elem_t));
+  matmul_config_ld(DIM*sizeof(elem_t));
+  matmul_mvin(Narrow, 0);
+  matmul_config_ld(WIDE_DIM*sizeof(elem_t));
+  matmul_mvin(Wide, DIM);
+  matmul_config_ld(WIDE_DIM*sizeof(elem_t));
+  matmul_config_st(DIM*sizeof(elem_t));
+  matmul_mvout(Out[1], DIM);
+  matmul_config_ld(DIM*sizeof(elem_t));
+  matmul_mvin(Narrow, 2*DIM);
+  matmul_mvout(Out[0], 2*DIM);
+  matmul_fence();
+
+  if (matmul_config_cache.issued - issued != 4 ||
+      matmul_config_cache.suppressed - suppressed != 2) {
+    printf("Wrong number of CONFIG commands issued\n");
+    print_matmul_config_cache();
+    exit(1);
+  }
+
+  // Suppressing a CONFIG mustn't change the stride the mvins were done with
+  for (size_t i = 0; i < DIM; i++)
+    for (size_t j = 0; j < DIM; j++)
+      if (Out[0][i][j] != Narrow[i][j] || Out[1][i][j] != Wide[i][j]) {
+        printf("Moved out matrix is incorrect at (%lu, %lu)\n", i, j);
+        exit(1);
+      }
+
+  // The cache is forgotten on a flush
+  matmul_flush(0);
+  matmul_config_ld(DIM*sizeof(elem_t));
+
+  if (matmul_config_cache.issued - issued != 5) {
+    printf("CONFIG wasn't issued after a flush\n");
+    exit(1);
+  }
+
+  exit(0);
+}
+
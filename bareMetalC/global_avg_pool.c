@@ -0,0 +1,93 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// batch_size, pixels, channels, out_pixels.
+// These cover pixel counts which are and aren't powers of 2, channel counts
+// which aren't multiples of DIM, and both output layouts.
+static const size_t pools[][4] = {
+  {1, 49, 64, 0},
+  {4, 49, 40, 16},
+  {3, 16, 20, 0},
+  {2, 9, 32, 4},
+};
+
+#define MAX_INPUT_ELEMS 8192
+#define MAX_OUTPUT_ELEMS 1024
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t input[MAX_INPUT_ELEMS] row_align(1);
+  static elem_t output[MAX_OUTPUT_ELEMS] row_align(1);
+  static elem_t gold[MAX_OUTPUT_ELEMS];
+
+  for (size_t s = 0; s < sizeof(pools) / sizeof(pools[0]); s++) {
+    const size_t batch_size = pools[s][0], pixels = pools[s][1];
+    const size_t channels = pools[s][2], out_pixels = pools[s][3];
+    const size_t rows = out_pixels == 0 ? batch_size : out_pixels;
+
+    assert(batch_size * pixels * channels <= MAX_INPUT_ELEMS);
+    assert(rows * channels <= MAX_OUTPUT_ELEMS);
+
+    for (size_t i = 0; i < batch_size * pixels * channels; i++)
+      input[i] = rand() % 2 ? elem_t_max - rand() % 8 : (rand() % 64) - 32;
+
+    elem_t m;
+    int shift;
+    tiled_global_avg_pool_scale(pixels, &m, &shift);
+
+    // The reference sums in an acc_t, so saturated inputs can't overflow
+    for (size_t c = 0; c < channels; c++) {
+      for (size_t b = 0; b < rows; b++) {
+        acc_t sum = 0;
+        for (size_t p = 0; b < batch_size && p < pixels; p++)
+          sum += input[(b*pixels + p)*channels + c];
+
+        const acc_t mean = ROUNDING_RIGHT_SHIFT(sum * m, shift);
+        const size_t o = out_pixels == 0 ? b*channels + c : c*out_pixels + b;
+        gold[o] = mean > elem_t_max ? elem_t_max : mean;
+
+        // The scale only approximates 1/pixels, so the mean is within one of
+        // the exact one
+        const acc_t exact = (sum + (acc_t)pixels/2) / (acc_t)pixels;
+        assert(b >= batch_size || (gold[o] - exact <= 1 && exact - gold[o] <= 1));
+      }
+    }
+
+    for (enum tiled_matmul_type_t option = OS; option <= AUTO; option++) {
+      printf("%lu images of %lux%lu, out_pixels %lu, option %d\n",
+          batch_size, pixels, channels, out_pixels, option);
+
+      for (size_t i = 0; i < rows * channels; i++)
+        output[i] = 1;
+
+      tiled_global_avg_pool(batch_size, pixels, channels, input, output,
+          out_pixels, option);
+
+      for (size_t i = 0; i < rows * channels; i++) {
+        if (output[i] != gold[i]) {
+          printf("Incorrect at %lu: %d != %d\n", i, output[i], gold[i]);
+          exit(1);
+        }
+      }
+    }
+  }
+
+  exit(0);
+}
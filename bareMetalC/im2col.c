@@ -0,0 +1,172 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// channels, in_dim, stride, padding, kernel_dim of mobilenetv2's im2col
+// layers: the first 3x3 conv, followed by the 1x1 expand and project convs at
+// every resolution. The baremetal shapes are scaled down.
+#ifndef BAREMETAL
+static const size_t convs[][5] = {
+  {3, 224, 2, 1, 3},
+  {32, 112, 1, 0, 1},
+  {96, 56, 1, 0, 1},
+  {144, 56, 1, 0, 1},
+  {192, 28, 1, 0, 1},
+  {384, 14, 1, 0, 1},
+  {576, 14, 1, 0, 1},
+  {960, 7, 1, 0, 1},
+};
+
+#define MAX_INPUT_ELEMS (144*56*56)
+#define MAX_PATCH_ELEMS (144*56*56)
+#else
+static const size_t convs[][5] = {
+  {3, 28, 2, 1, 3},
+  {32, 14, 1, 0, 1},
+  {144, 7, 1, 0, 1},
+  {960, 2, 1, 0, 1},
+  {16, 9, 2, 2, 5},
+};
+
+#define MAX_INPUT_ELEMS (144*7*7)
+#define MAX_PATCH_ELEMS (25*400)
+#endif
+
+// The im2col mobilenet used before im2col_nchw, which bounds-checks every
+// element, and relies on the patch matrix being zeroed beforehand
+static void im2col_ref(size_t channels, size_t in_dim, size_t stride,
+    size_t padding, size_t kernel_dim, size_t K,
+    const elem_t input[channels][in_dim][in_dim], elem_t output[][K])
+{
+    int patch_row = 0;
+
+    for (int im_row = -padding; im_row < (int)(in_dim - kernel_dim + padding + 1); im_row += stride) {
+        for (int im_col = -padding; im_col < (int)(in_dim - kernel_dim + padding + 1); im_col += stride) {
+            int patch_col = 0;
+
+            for (int im_channel = 0; im_channel < channels; im_channel++) {
+                for (int filter_row = 0; filter_row < kernel_dim; filter_row++) {
+                    for (int filter_col = 0; filter_col < kernel_dim; filter_col++) {
+                        int pixel_row = im_row + filter_row;
+                        int pixel_col = im_col + filter_col;
+
+                        if (pixel_row < 0 || pixel_row >= in_dim
+                            || pixel_col < 0 || pixel_col >= in_dim) {
+                            // output[patch_row][patch_col] = 0;
+                        } else {
+                            output[patch_row][patch_col] = input[im_channel][pixel_row][pixel_col];
+                        }
+
+                        patch_col++;
+                    }
+                }
+            }
+
+            patch_row++;
+        }
+    }
+}
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  static elem_t input[MAX_INPUT_ELEMS];
+  static elem_t input_nhwc[MAX_INPUT_ELEMS];
+  static elem_t gold[MAX_PATCH_ELEMS];
+  static elem_t patches[MAX_PATCH_ELEMS];
+  static elem_t patches_nhwc[2 * MAX_PATCH_ELEMS];
+
+  for (size_t s = 0; s < sizeof(convs) / sizeof(convs[0]); s++) {
+    const size_t channels = convs[s][0], in_dim = convs[s][1];
+    const size_t stride = convs[s][2], padding = convs[s][3];
+    const size_t kernel_dim = convs[s][4];
+    const size_t out_dim = (in_dim + 2*padding - kernel_dim) / stride + 1;
+
+    const size_t I = out_dim * out_dim;
+    const size_t K = channels * kernel_dim * kernel_dim;
+
+    assert(channels * in_dim * in_dim <= MAX_INPUT_ELEMS);
+    assert(I * K <= MAX_PATCH_ELEMS);
+
+    for (size_t i = 0; i < channels * in_dim * in_dim; i++)
+      input[i] = rand();
+
+    for (size_t c = 0; c < channels; c++)
+      for (size_t p = 0; p < in_dim * in_dim; p++)
+        input_nhwc[p * channels + c] = input[c * in_dim * in_dim + p];
+
+    for (size_t i = 0; i < I * K; i++) {
+      gold[i] = 0;
+      patches[i] = 1;
+    }
+
+    const unsigned long ref_start = read_cycles();
+    im2col_ref(channels, in_dim, stride, padding, kernel_dim, K,
+        (void*)input, (void*)gold);
+    const unsigned long ref_end = read_cycles();
+
+    const unsigned long start = read_cycles();
+    im2col_nchw(1, channels, in_dim, out_dim, stride, padding, kernel_dim,
+        (void*)input, (void*)patches);
+    const unsigned long end = read_cycles();
+
+    printf("%lux%lux%lu, stride %lu, padding %lu, %lux%lu kernel: %lu cycles, reference: %lu cycles\n",
+        channels, in_dim, in_dim, stride, padding, kernel_dim, kernel_dim,
+        end - start, ref_end - ref_start);
+
+    for (size_t i = 0; i < I * K; i++)
+      if (patches[i] != gold[i]) {
+        printf("im2col is incorrect at (%lu, %lu): %d != %d\n",
+            i / K, i % K, patches[i], gold[i]);
+        exit(1);
+      }
+
+    // The NHWC patch rows are padded, to check that the padding is left alone
+    const size_t row_len = K + 1;
+
+    for (size_t i = 0; i < I * row_len; i++)
+      patches_nhwc[i] = 1;
+
+    const unsigned long nhwc_start = read_cycles();
+    im2col_nhwc(1, channels, in_dim, out_dim, stride, padding, kernel_dim,
+        (void*)input_nhwc, row_len, (void*)patches_nhwc);
+    const unsigned long nhwc_end = read_cycles();
+
+    printf("  NHWC: %lu cycles\n", nhwc_end - nhwc_start);
+
+    // Its columns are in (kernel row, kernel col, channel) order
+    for (size_t i = 0; i < I; i++) {
+      for (size_t k = 0; k < K; k++) {
+        const size_t kpos = k / channels, c = k % channels;
+        const elem_t expected = gold[i * K + c * kernel_dim * kernel_dim + kpos];
+
+        if (patches_nhwc[i * row_len + k] != expected) {
+          printf("NHWC im2col is incorrect at (%lu, %lu): %d != %d\n",
+              i, k, patches_nhwc[i * row_len + k], expected);
+          exit(1);
+        }
+      }
+
+      if (patches_nhwc[i * row_len + K] != 1) {
+        printf("NHWC im2col wrote past row %lu\n", i);
+        exit(1);
+      }
+    }
+  }
+
+  exit(0);
+}
+
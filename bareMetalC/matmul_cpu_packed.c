@@ -0,0 +1,104 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// I, J, K, C_pixels.
+// These cover dimensions which aren't multiples of the register blocks, more
+// columns than fit in the packing buffer at once, a K too large for even one
+// packed panel, and channel-major outputs.
+static const size_t matmuls[][4] = {
+  {37, 29, 45, 0},
+  {8, 300, 400, 0},
+  {5, 3, 16400, 0},
+  {18, 20, 33, 9},
+};
+
+#define MAX_A_ELEMS (5*16400)
+#define MAX_B_ELEMS (300*400)
+#define MAX_C_ELEMS (37*300)
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  static elem_t A[MAX_A_ELEMS];
+  static elem_t B[MAX_B_ELEMS];
+  static acc_t D_acc[MAX_C_ELEMS];
+  static elem_t D_elem[MAX_C_ELEMS];
+  static elem_t R[MAX_C_ELEMS];
+  static elem_t C[MAX_C_ELEMS];
+  static elem_t gold[MAX_C_ELEMS];
+
+  for (size_t s = 0; s < sizeof(matmuls) / sizeof(matmuls[0]); s++) {
+    const size_t I = matmuls[s][0], J = matmuls[s][1], K = matmuls[s][2];
+    const size_t C_pixels = matmuls[s][3];
+
+    assert(I*K <= MAX_A_ELEMS && K*J <= MAX_B_ELEMS && I*J <= MAX_C_ELEMS);
+
+    for (size_t i = 0; i < I*K; i++)
+      A[i] = (rand() % 256) - 128;
+    for (size_t i = 0; i < K*J; i++)
+      B[i] = (rand() % 256) - 128;
+    for (size_t i = 0; i < I*J; i++) {
+      D_acc[i] = (rand() % 65536) - 32768;
+      D_elem[i] = (rand() % 256) - 128;
+      R[i] = (rand() % 256) - 128;
+    }
+
+    const struct tiled_matmul_residual_t res = {
+      .R = R, .row_len = J, .cols = J, .shift = 1,
+    };
+
+    // bias: none, elem_t or acc_t, with and without a residual
+    for (int bias = 0; bias < 3; bias++) {
+      for (int act = NO_ACTIVATION; act <= RELU6; act++) {
+        for (int with_res = 0; with_res <= 1; with_res++) {
+          const int shift = 4 + 3*act;
+          void * D = bias == 0 ? NULL : (bias == 1 ? (void*)D_elem : (void*)D_acc);
+
+          printf("%lux%lux%lu, C_pixels %lu, bias %d, act %d, residual %d\n",
+              I, J, K, C_pixels, bias, act, with_res);
+
+          for (size_t i = 0; i < I; i++) {
+            for (size_t j = 0; j < J; j++) {
+              acc_t result = bias == 0 ? 0 : (bias == 1 ? D_elem[i*J + j] : D_acc[i*J + j]);
+              if (with_res)
+                result += tiled_matmul_residual_at(&res, shift, i, j);
+              for (size_t k = 0; k < K; k++)
+                result += A[i*K + k] * B[k*J + j];
+
+              const size_t c = C_pixels == 0 ? i*J + j :
+                ((i / C_pixels)*J + j)*C_pixels + i % C_pixels;
+              gold[c] = matmul_cpu_scale(result, act, shift, 2);
+            }
+          }
+
+          matmul_cpu_pixels(I, J, K, (void*)A, (void*)B, D,
+              with_res ? &res : NULL, C, C_pixels,
+              act, shift, 2, bias == 2);
+
+          for (size_t i = 0; i < I*J; i++) {
+            if (C[i] != gold[i]) {
+              printf("Incorrect at %lu: %d != %d\n", i, C[i], gold[i]);
+              exit(1);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  exit(0);
+}
@@ -0,0 +1,95 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+#define BIG_DIM 64
+
+#if (BIG_DIM % DIM) != 0
+#error incorrect dimensions
+#endif
+
+#if (BIG_DIM * BIG_DIM / DIM) > ACC_ROWS
+#error not enough rows
+#endif
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+#if MAX_BLOCK_LEN_ST == 1
+  // This generator's mvouts only carry a single block, so only block_len 1 is
+  // exercised below
+  printf("MAX_BLOCK_LEN_ST is 1: only single-block mvouts are tested\n");
+#endif
+
+  static elem_t In[BIG_DIM][BIG_DIM] row_align(1);
+  static acc_t In_acc[BIG_DIM][BIG_DIM] row_align_acc(1);
+  static elem_t Out[BIG_DIM][BIG_DIM] row_align(1);
+
+  for (size_t i = 0; i < BIG_DIM; ++i)
+    for (size_t j = 0; j < BIG_DIM; ++j) {
+      In[i][j] = (rand() % 64) - 32;
+      In_acc[i][j] = In[i][j];
+    }
+
+  matmul_config_ex(0, NO_ACTIVATION, 0, 0, 0);
+  matmul_config_st(BIG_DIM*sizeof(elem_t));
+
+  // Move the matrix into the scratchpad and the accumulator one block at a
+  // time, with each row of blocks laid out contiguously
+  for (size_t i = 0; i < BIG_DIM; i += DIM) {
+    for (size_t j = 0; j < BIG_DIM; j += DIM) {
+      const uint32_t sp_addr = i*(BIG_DIM/DIM) + j;
+
+      matmul_config_ld(BIG_DIM*sizeof(elem_t));
+      matmul_mvin(&In[i][j], sp_addr);
+      matmul_config_ld(BIG_DIM*sizeof(acc_t));
+      matmul_mvin(&In_acc[i][j], (1 << (ADDR_LEN-1)) | sp_addr);
+    }
+  }
+
+  for (int acc = 0; acc <= 1; acc++) {
+    for (int block_len = 1; block_len <= BIG_DIM/DIM && block_len <= MAX_BLOCK_LEN_ST; block_len++) {
+      for (size_t i = 0; i < BIG_DIM; ++i)
+        for (size_t j = 0; j < BIG_DIM; ++j)
+          Out[i][j] = 0;
+
+      for (size_t i = 0; i < BIG_DIM; i += DIM) {
+        for (size_t j = 0; j < BIG_DIM; j += block_len*DIM) {
+          const uint32_t sp_addr = (acc ? 3 << (ADDR_LEN-2) : 0) |
+            (i*(BIG_DIM/DIM) + j);
+          const int len = j + block_len*DIM <= BIG_DIM ? block_len : (BIG_DIM-j)/DIM;
+
+          matmul_block_mvout(&Out[i][j], sp_addr, len);
+        }
+      }
+
+      matmul_fence();
+
+      for (size_t i = 0; i < BIG_DIM; ++i)
+        for (size_t j = 0; j < BIG_DIM; ++j)
+          if (Out[i][j] != In[i][j]) {
+            printf("fails at block_len: %d, acc: %d, (%lu, %lu)\n", block_len,
+                acc, i, j);
+            exit(1);
+          }
+    }
+  }
+
+  exit(0);
+}
+
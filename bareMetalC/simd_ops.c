@@ -0,0 +1,107 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// Lengths which are shorter than a vector, whole vectors, and whole vectors
+// followed by a scalar tail
+static const size_t lengths[] = {1, 7, 16, 17, 64, 100};
+
+#define MAX_N 100
+
+static void fail(const char * op, size_t n, size_t i, int param) {
+  printf("%s is incorrect for n = %lu, param %d, at %lu\n", op, n, param, i);
+  exit(1);
+}
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  static elem_t in[MAX_N], out[MAX_N], out2[MAX_N];
+  static acc_t acc[MAX_N];
+  static int64_t full[MAX_N];
+
+  for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+    const size_t n = lengths[l];
+
+    for (size_t i = 0; i < n; i++) {
+      in[i] = rand();
+      acc[i] = (int32_t)((rand() << 24) | (rand() << 12) | rand()) >> 8;
+      full[i] = (int64_t)acc[i] * 37;
+    }
+
+    printf("n = %lu\n", n);
+
+    // Clamps
+    for (int lo = -128; lo <= 32; lo += 32) {
+      const int hi = lo + 64 > elem_t_max ? elem_t_max : lo + 64;
+      simd_clamp(n, in, out, lo, hi);
+      for (size_t i = 0; i < n; i++)
+        if (out[i] != (in[i] < lo ? lo : (in[i] > hi ? hi : in[i])))
+          fail("simd_clamp", n, i, lo);
+    }
+
+    // Rounding shifts
+    for (int shift = 0; shift <= 24; shift++) {
+      simd_shift_full(n, full, out, shift);
+      for (size_t i = 0; i < n; i++) {
+        const int64_t shifted = ROUNDING_RIGHT_SHIFT(full[i], shift);
+        const elem_t gold = shifted > elem_t_max ? elem_t_max :
+          (shifted < elem_t_min ? elem_t_min : shifted);
+        if (out[i] != gold)
+          fail("simd_shift_full", n, i, shift);
+      }
+
+      for (int act = NO_ACTIVATION; act <= RELU6; act++) {
+        for (int relu6_shift = 0; relu6_shift <= 5; relu6_shift++) {
+          matmul_cpu_scale_row(n, acc, out, act, shift, relu6_shift);
+          for (size_t i = 0; i < n; i++)
+            if (out[i] != matmul_cpu_scale(acc[i], act, shift, relu6_shift))
+              fail("matmul_cpu_scale_row", n, i, shift);
+        }
+      }
+    }
+
+    // Residual adds
+    for (int shift = 0; shift <= 8; shift++) {
+      for (size_t i = 0; i < n; i++)
+        out[i] = out2[i] = rand();
+
+      simd_add_shifted(n, in, shift, out);
+      for (size_t i = 0; i < n; i++) {
+        const acc_t sum = ROUNDING_RIGHT_SHIFT((acc_t)in[i], shift) + out2[i];
+        const elem_t gold = sum > elem_t_max ? elem_t_max : (sum < elem_t_min ? elem_t_min : sum);
+        if (out[i] != gold)
+          fail("simd_add_shifted", n, i, shift);
+      }
+    }
+
+    // Comparisons, with a difference in every possible position
+    for (size_t i = 0; i < n; i++)
+      out[i] = in[i];
+
+    if (!simd_equal(n, in, out))
+      fail("simd_equal", n, 0, 0);
+
+    for (size_t i = 0; i < n; i++) {
+      out[i] ^= 1;
+      if (simd_equal(n, in, out))
+        fail("simd_equal", n, i, 1);
+      out[i] ^= 1;
+    }
+  }
+
+  exit(0);
+}
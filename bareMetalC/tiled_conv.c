@@ -0,0 +1,126 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// batch_size, in_dim, in_channels, out_channels, stride, padding, kernel_dim.
+// These cover kernel rows which are whole multiples of DIM, patch columns
+// which straddle two kernel rows, strides larger than one, and padding on
+// every side, as well as pointwise convs, which are run as plain matmuls
+// when they aren't strided.
+static const size_t convs[][7] = {
+  {2, 8, 16, 20, 1, 1, 3},
+  {1, 9, 16, 16, 2, 1, 3},
+  {1, 15, 3, 16, 2, 3, 7},
+  {1, 8, 24, 16, 2, 0, 1},
+  {2, 4, 24, 20, 1, 0, 1},
+};
+
+#define MAX_INPUT_ELEMS 2048
+#define MAX_I 128
+#define MAX_J 20
+#define MAX_K 160
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t input[MAX_INPUT_ELEMS] row_align(1);
+  static elem_t weights[MAX_K * MAX_J] row_align(1);
+  static acc_t bias[MAX_I * MAX_J] row_align_acc(1);
+  static elem_t output[MAX_I * MAX_J] row_align(1);
+  static elem_t patches[MAX_I * MAX_K];
+  static elem_t gold[MAX_I * MAX_J];
+  static elem_t direct[MAX_I * MAX_J];
+
+  for (size_t s = 0; s < sizeof(convs) / sizeof(convs[0]); s++) {
+    const size_t batch_size = convs[s][0], in_dim = convs[s][1];
+    const size_t in_channels = convs[s][2], out_channels = convs[s][3];
+    const size_t stride = convs[s][4], padding = convs[s][5];
+    const size_t kernel_dim = convs[s][6];
+    const size_t out_dim = (in_dim + 2*padding - kernel_dim) / stride + 1;
+
+    const size_t I = batch_size * out_dim * out_dim;
+    const size_t J = out_channels;
+    const size_t K = kernel_dim * kernel_dim * in_channels;
+
+    assert(batch_size * in_dim * in_dim * in_channels <= MAX_INPUT_ELEMS);
+    assert(I <= MAX_I && J <= MAX_J && K <= MAX_K);
+
+    elem_t (*in)[in_dim][in_dim][in_channels] = (void*)input;
+    elem_t (*A)[K] = (void*)patches;
+
+    for (size_t i = 0; i < batch_size * in_dim * in_dim * in_channels; i++)
+      input[i] = (rand() % 5) - 2;
+
+    for (size_t i = 0; i < K * J; i++)
+      weights[i] = (rand() % 5) - 2;
+
+    for (size_t i = 0; i < I * J; i++)
+      bias[i] = (rand() % 5) - 2;
+
+    // The reference is an explicit im2col, followed by a matmul
+    for (size_t p = 0; p < I; p++) {
+      const size_t n = p / (out_dim*out_dim);
+      const int oh = (p / out_dim) % out_dim;
+      const int ow = p % out_dim;
+
+      for (size_t k = 0; k < K; k++) {
+        const size_t kpos = k / in_channels;
+        const int ih = oh*stride - padding + kpos / kernel_dim;
+        const int iw = ow*stride - padding + kpos % kernel_dim;
+
+        if (ih < 0 || ih >= (int)in_dim || iw < 0 || iw >= (int)in_dim)
+          A[p][k] = 0;
+        else
+          A[p][k] = in[n][ih][iw][k % in_channels];
+      }
+    }
+
+    for (enum tiled_matmul_type_t option = OS; option <= AUTO; option++) {
+      for (int full_bias_width = 0; full_bias_width <= 1; full_bias_width++) {
+        for (int no_bias = 0; no_bias <= 1; no_bias++) {
+          void * D = no_bias ? NULL : bias;
+
+          printf("%lux%lux%lu, stride %lu, padding %lu, %lux%lu kernel, option %d, full_bias_width %d, no_bias %d\n",
+              in_dim, in_dim, in_channels, stride, padding, kernel_dim,
+              kernel_dim, option, full_bias_width, no_bias);
+
+          tiled_conv(batch_size, in_dim, in_channels, out_channels, out_dim,
+              stride, padding, kernel_dim, in, (void*)weights, D,
+              (void*)output, RELU, 1, 0, full_bias_width, option);
+
+          matmul_cpu(I, J, K, A, (void*)weights, D, (void*)gold,
+              RELU, 1, 0, full_bias_width);
+
+          conv_cpu(batch_size, in_dim, in_channels, out_channels, out_dim,
+              stride, padding, kernel_dim, in, (void*)weights, D, NULL,
+              (void*)direct, RELU, 1, 0, full_bias_width);
+
+          for (size_t i = 0; i < I * J; i++)
+            if (output[i] != gold[i] || direct[i] != gold[i]) {
+              printf("Conv is incorrect at (%lu, %lu): %d != %d\n",
+                  i / J, i % J, output[i], gold[i]);
+              exit(1);
+            }
+        }
+      }
+    }
+  }
+
+  exit(0);
+}
+
@@ -0,0 +1,113 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// batch_size, in_dim, channels, stride, padding, kernel_dim.
+// These cover channel counts which aren't multiples of DIM, strides larger
+// than one, padding on every side, and more output pixels than fit in one
+// tile of the accumulator.
+static const size_t convs[][6] = {
+  {1, 8, 32, 1, 1, 3},
+  {2, 9, 20, 2, 1, 3},
+  {1, 7, 8, 1, 2, 5},
+  {1, 24, 16, 1, 1, 3},
+};
+
+#define MAX_INPUT_ELEMS 9216
+#define MAX_WEIGHT_ELEMS 512
+#define MAX_CHANNELS 32
+#define MAX_OUTPUT_ELEMS 9216
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t input[MAX_INPUT_ELEMS] row_align(1);
+  static elem_t weights[MAX_WEIGHT_ELEMS];
+  static acc_t bias[MAX_CHANNELS] row_align_acc(1);
+  static elem_t output[MAX_OUTPUT_ELEMS] row_align(1);
+  static elem_t gold[MAX_OUTPUT_ELEMS];
+
+  for (size_t s = 0; s < sizeof(convs) / sizeof(convs[0]); s++) {
+    const size_t batch_size = convs[s][0], in_dim = convs[s][1];
+    const size_t channels = convs[s][2], stride = convs[s][3];
+    const size_t padding = convs[s][4], kernel_dim = convs[s][5];
+    const size_t out_dim = (in_dim + 2*padding - kernel_dim) / stride + 1;
+    const size_t pixels = batch_size * out_dim * out_dim;
+
+    assert(batch_size * in_dim * in_dim * channels <= MAX_INPUT_ELEMS);
+    assert(channels * kernel_dim * kernel_dim <= MAX_WEIGHT_ELEMS);
+    assert(channels <= MAX_CHANNELS);
+    assert(pixels * channels <= MAX_OUTPUT_ELEMS);
+
+    elem_t (*in)[in_dim][in_dim][channels] = (void*)input;
+    elem_t (*w)[kernel_dim][kernel_dim] = (void*)weights;
+
+    for (size_t i = 0; i < batch_size * in_dim * in_dim * channels; i++)
+      input[i] = (rand() % 5) - 2;
+
+    for (size_t i = 0; i < channels * kernel_dim * kernel_dim; i++)
+      weights[i] = (rand() % 5) - 2;
+
+    for (size_t i = 0; i < channels; i++)
+      bias[i] = (rand() % 5) - 2;
+
+    for (enum tiled_matmul_type_t option = OS; option <= AUTO; option++) {
+      for (int no_bias = 0; no_bias <= 1; no_bias++) {
+        acc_t * b = no_bias ? NULL : bias;
+
+        printf("%lux%lux%lu, stride %lu, padding %lu, %lux%lu kernel, option %d, no_bias %d\n",
+            in_dim, in_dim, channels, stride, padding, kernel_dim,
+            kernel_dim, option, no_bias);
+
+        tiled_conv_dw(batch_size, in_dim, channels, out_dim, stride, padding,
+            kernel_dim, in, w, b, (void*)output, RELU, 1, 0, option);
+
+        // The reference accumulates one channel of one output pixel at a time
+        for (size_t p = 0; p < pixels; p++) {
+          const size_t n = p / (out_dim*out_dim);
+          const int oh = (p / out_dim) % out_dim;
+          const int ow = p % out_dim;
+
+          for (size_t c = 0; c < channels; c++) {
+            acc_t result = no_bias ? 0 : bias[c];
+
+            for (size_t kh = 0; kh < kernel_dim; kh++)
+              for (size_t kw = 0; kw < kernel_dim; kw++) {
+                const int ih = oh*stride - padding + kh;
+                const int iw = ow*stride - padding + kw;
+
+                if (ih >= 0 && ih < (int)in_dim && iw >= 0 && iw < (int)in_dim)
+                  result += in[n][ih][iw][c] * w[c][kh][kw];
+              }
+
+            gold[p*channels + c] = matmul_cpu_scale(result, RELU, 1, 0);
+          }
+        }
+
+        for (size_t i = 0; i < pixels * channels; i++)
+          if (output[i] != gold[i]) {
+            printf("Depthwise conv is incorrect at (%lu, %lu): %d != %d\n",
+                i / channels, i % channels, output[i], gold[i]);
+            exit(1);
+          }
+      }
+    }
+  }
+
+  exit(0);
+}
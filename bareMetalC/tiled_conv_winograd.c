@@ -0,0 +1,114 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// batch_size, dim, in_channels, out_channels, shift, input range.
+// These cover odd image sizes, whose last tiles are only partly in the output,
+// channel counts which aren't multiples of DIM, and inputs which are small
+// enough for their transform to fit in an elem_t without being shifted.
+static const size_t convs[][6] = {
+  {1, 8, 32, 32, 7, 128},
+  {2, 7, 20, 24, 6, 128},
+  {1, 14, 64, 16, 8, 128},
+  {1, 5, 16, 16, 4, 16},
+};
+
+#define MAX_INPUT_ELEMS 12544
+#define MAX_WEIGHT_ELEMS (9*64*32)
+#define MAX_CHANNELS 32
+#define MAX_OUTPUT_ELEMS 3136
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t input[MAX_INPUT_ELEMS] row_align(1);
+  static elem_t weights[MAX_WEIGHT_ELEMS] row_align(1);
+  static elem_t U[16*MAX_WEIGHT_ELEMS/9] row_align(1);
+  static acc_t bias[MAX_CHANNELS];
+  static acc_t D[MAX_OUTPUT_ELEMS];
+  static elem_t output[MAX_OUTPUT_ELEMS] row_align(1);
+  static elem_t first[MAX_OUTPUT_ELEMS];
+  static elem_t gold[MAX_OUTPUT_ELEMS];
+
+  // Weights whose transform doesn't fit are rejected
+  for (size_t i = 0; i < 9*16*16; i++)
+    weights[i] = 100;
+  assert(!winograd_transform_weights(16, 16, (void*)weights, (void*)U));
+
+  for (size_t s = 0; s < sizeof(convs) / sizeof(convs[0]); s++) {
+    const size_t batch_size = convs[s][0], dim = convs[s][1];
+    const size_t in_channels = convs[s][2], out_channels = convs[s][3];
+    const int shift = convs[s][4], range = convs[s][5];
+    const size_t pixels = batch_size * dim * dim;
+
+    assert(pixels * in_channels <= MAX_INPUT_ELEMS);
+    assert(9 * in_channels * out_channels <= MAX_WEIGHT_ELEMS);
+    assert(out_channels <= MAX_CHANNELS);
+    assert(pixels * out_channels <= MAX_OUTPUT_ELEMS);
+
+    for (size_t i = 0; i < pixels * in_channels; i++)
+      input[i] = (rand() % (2*range)) - range;
+
+    for (size_t i = 0; i < 9 * in_channels * out_channels; i++)
+      weights[i] = (rand() % 15) - 7;
+
+    for (size_t i = 0; i < out_channels; i++)
+      bias[i] = (rand() % 512) - 256;
+
+    for (size_t p = 0; p < pixels; p++)
+      for (size_t oc = 0; oc < out_channels; oc++)
+        D[p*out_channels + oc] = bias[oc];
+
+    assert(winograd_transform_weights(in_channels, out_channels,
+          (void*)weights, (void*)U));
+
+    conv_cpu(batch_size, dim, in_channels, out_channels, dim, 1, 1, 3,
+        (void*)input, (void*)weights, D, NULL, (void*)gold,
+        NO_ACTIVATION, shift, 0, 1);
+
+    for (enum tiled_matmul_type_t option = OS; option <= AUTO; option++) {
+      printf("%lux%lux%lu to %lu channels, shift %d, option %d\n",
+          batch_size, dim, in_channels, out_channels, shift, option);
+
+      if (!tiled_conv_winograd(batch_size, dim, in_channels, out_channels,
+            (void*)input, (void*)U, bias, (void*)output,
+            NO_ACTIVATION, shift, 0, option)) {
+        printf("Winograd buffers are too small\n");
+        exit(1);
+      }
+
+      if (!winograd_within_tolerance(pixels * out_channels, output, gold)) {
+        printf("Not within the tolerance of the exact conv\n");
+        exit(1);
+      }
+
+      // Every option runs the same products, so they should all match exactly
+      for (size_t i = 0; i < pixels * out_channels; i++) {
+        if (option != OS && output[i] != first[i]) {
+          printf("Incorrect at %lu: %d, OS gives %d\n", i, output[i], first[i]);
+          exit(1);
+        }
+
+        if (option == OS)
+          first[i] = output[i];
+      }
+    }
+  }
+
+  exit(0);
+}
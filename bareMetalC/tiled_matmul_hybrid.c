@@ -0,0 +1,87 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// I, J, K, residual shift, shift.
+// These cover dimensions which aren't multiples of DIM or of the CPU's
+// register blocks, skinny matmuls with a few tiles of rows, and a residual
+// which is too large to be fused. Each matmul is run several times, so that
+// the split moves as the measured rates are updated.
+static const size_t matmuls[][5] = {
+  {100, 70, 50, 1, 3},
+  {64, 1000, 128, 0, 6},
+  {257, 13, 75, 4, 2},
+  {16, 48, 300, 0, 4},
+};
+
+#define RUNS 3
+#define MAX_A_ELEMS (257*300)
+#define MAX_B_ELEMS (1000*300)
+#define MAX_C_ELEMS (257*1000)
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t A[MAX_A_ELEMS] row_align(1);
+  static elem_t B[MAX_B_ELEMS] row_align(1);
+  static acc_t D[MAX_C_ELEMS] row_align_acc(1);
+  static elem_t R[MAX_C_ELEMS] row_align(1);
+  static elem_t C[MAX_C_ELEMS] row_align(1);
+  static elem_t gold[MAX_C_ELEMS];
+
+  for (size_t s = 0; s < sizeof(matmuls) / sizeof(matmuls[0]); s++) {
+    const size_t I = matmuls[s][0], J = matmuls[s][1], K = matmuls[s][2];
+    const int res_shift = matmuls[s][3], shift = matmuls[s][4];
+
+    assert(I*K <= MAX_A_ELEMS && K*J <= MAX_B_ELEMS && I*J <= MAX_C_ELEMS);
+
+    for (size_t i = 0; i < I*K; i++)
+      A[i] = (rand() % 5) - 2;
+    for (size_t i = 0; i < K*J; i++)
+      B[i] = (rand() % 5) - 2;
+    for (size_t i = 0; i < I*J; i++) {
+      D[i] = (rand() % 64) - 32;
+      R[i] = (rand() % 64) - 32;
+    }
+
+    const struct tiled_matmul_residual_t res = {
+      .R = R, .row_len = J, .cols = J, .shift = res_shift,
+    };
+
+    tiled_matmul_residual(I, J, K, (void*)A, (void*)B, D, &res, (void*)gold,
+        RELU, shift, 0, 1, CPU);
+
+    for (int run = 0; run < RUNS; run++) {
+      printf("%lux%lux%lu matmul, run %d\n", I, J, K, run);
+
+      for (size_t i = 0; i < I*J; i++)
+        C[i] = 0;
+
+      tiled_matmul_residual(I, J, K, (void*)A, (void*)B, D, &res, (void*)C,
+          RELU, shift, 0, 1, HYBRID);
+
+      for (size_t i = 0; i < I*J; i++)
+        if (C[i] != gold[i]) {
+          printf("Incorrect at (%lu, %lu): %d != %d\n", i / J, i % J, C[i], gold[i]);
+          exit(1);
+        }
+    }
+  }
+
+  exit(0);
+}
@@ -0,0 +1,116 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// Dimensions which aren't multiples of DIM, so that the last tile along every
+// loop is ragged
+#ifndef BAREMETAL
+#define MAT_DIM_I 150
+#define MAT_DIM_K 130
+#define MAT_DIM_J 110
+#define TILE_I 2
+#define TILE_J 2
+#define TILE_K 2
+#else
+#define MAT_DIM_I 45
+#define MAT_DIM_K 37
+#define MAT_DIM_J 35
+#define TILE_I 1
+#define TILE_J 1
+#define TILE_K 1
+#endif
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t A[MAT_DIM_I][MAT_DIM_K] row_align(1);
+  static elem_t B[MAT_DIM_K][MAT_DIM_J] row_align(1);
+  static acc_t D[MAT_DIM_I][MAT_DIM_J] row_align_acc(1);
+  static elem_t C[MAT_DIM_I][MAT_DIM_J] row_align(1);
+  static elem_t gold[MAT_DIM_I][MAT_DIM_J];
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t k = 0; k < MAT_DIM_K; k++)
+      A[i][k] = (rand() % 3) - 1;
+
+  for (size_t k = 0; k < MAT_DIM_K; k++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      B[k][j] = (rand() % 3) - 1;
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      D[i][j] = (rand() % 3) - 1;
+
+  const size_t I0 = (MAT_DIM_I + TILE_I*DIM - 1) / (TILE_I*DIM);
+  const size_t J0 = (MAT_DIM_J + TILE_J*DIM - 1) / (TILE_J*DIM);
+  const size_t K0 = (MAT_DIM_K + TILE_K*DIM - 1) / (TILE_K*DIM);
+
+  for (enum tiled_matmul_type_t dataflow = OS; dataflow <= WS; dataflow++) {
+    for (enum tiled_matmul_loop_order_t loop_order = LOOP_IJK;
+        loop_order <= LOOP_KJI; loop_order++) {
+      for (int full_bias_width = 0; full_bias_width <= 1; full_bias_width++) {
+        printf("%s %s, full_bias_width: %d\n", dataflow == OS ? "OS" : "WS",
+            tiled_matmul_loop_vars[loop_order], full_bias_width);
+
+        if (dataflow == OS)
+          tiled_matmul_os(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, C,
+              TILE_I, TILE_J, TILE_K, loop_order,
+              RELU, 0, 0, full_bias_width);
+        else
+          tiled_matmul_ws(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, C,
+              TILE_I, TILE_J, TILE_K, loop_order,
+              RELU, 0, 0, full_bias_width);
+
+        matmul_cpu(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, gold,
+            RELU, 0, 0, full_bias_width);
+
+        for (size_t i = 0; i < MAT_DIM_I; i++)
+          for (size_t j = 0; j < MAT_DIM_J; j++)
+            if (C[i][j] != gold[i][j]) {
+              printf("Matmul is incorrect at (%lu, %lu): %d != %d\n",
+                  i, j, C[i][j], gold[i][j]);
+              exit(1);
+            }
+
+        print_tiled_matmul_counters();
+
+        // The counters have to agree with the reuse the planner assumes. Loop
+        // orders whose output tiles don't all fit in the accumulator fall
+        // back to LOOP_IJK
+        enum tiled_matmul_loop_order_t ran = loop_order;
+        if (tiled_matmul_loop_resident_tiles(loop_order, I0, J0, K0) *
+            TILE_I * TILE_J * DIM > ACC_ROWS)
+          ran = LOOP_IJK;
+
+        size_t A_reloads, B_reloads;
+        tiled_matmul_loop_reloads(ran, I0, J0, K0, &A_reloads, &B_reloads);
+
+        const struct tiled_matmul_counters_t * c = &tiled_matmul_counters;
+        if (c->A_loads != c->A_size * A_reloads ||
+            c->B_loads != c->B_size * B_reloads ||
+            c->C_stores != c->C_size) {
+          printf("Counters don't match the loop order\n");
+          exit(1);
+        }
+      }
+    }
+  }
+
+  exit(0);
+}
+
@@ -0,0 +1,90 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// The output is a batch of BATCH images of PIXELS pixels each, and its
+// dimensions aren't multiples of DIM, so that images start in the middle of
+// output tiles
+#define BATCH 3
+#ifndef BAREMETAL
+#define PIXELS 49
+#define MAT_DIM_K 70
+#define MAT_DIM_J 90
+#else
+#define PIXELS 25
+#define MAT_DIM_K 40
+#define MAT_DIM_J 35
+#endif
+#define MAT_DIM_I (BATCH*PIXELS)
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t A[MAT_DIM_I][MAT_DIM_K] row_align(1);
+  static elem_t B[MAT_DIM_K][MAT_DIM_J] row_align(1);
+  static acc_t D[MAT_DIM_I][MAT_DIM_J] row_align_acc(1);
+  static elem_t C[BATCH][MAT_DIM_J][PIXELS] row_align(1);
+  static elem_t gold[MAT_DIM_I][MAT_DIM_J];
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t k = 0; k < MAT_DIM_K; k++)
+      A[i][k] = (rand() % 3) - 1;
+
+  for (size_t k = 0; k < MAT_DIM_K; k++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      B[k][j] = (rand() % 3) - 1;
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      D[i][j] = (rand() % 3) - 1;
+
+  matmul_cpu(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, gold,
+      RELU, 0, 0, 1);
+
+  // Every option, followed by both dataflows with one-block tiles, so that
+  // the staging buffers are reused many times
+  for (int run = 0; run < 6; run++) {
+    for (size_t i = 0; i < sizeof(C); i++)
+      ((elem_t*)C)[i] = 0;
+
+    if (run <= AUTO) {
+      printf("option %d\n", run);
+      tiled_matmul_option_nchw(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D,
+          &C[0][0][0], PIXELS, RELU, 0, 0, 1, run);
+    } else if (run == 4) {
+      printf("OS, 1x1x1 tiles\n");
+      tiled_matmul_conv(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, (void*)C,
+          1, 1, 1, LOOP_IJK, OUTPUT_STATIONARY, NULL, PIXELS, NULL, RELU, 0, 0, 1);
+    } else {
+      printf("WS, 1x1x1 tiles\n");
+      tiled_matmul_conv(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, (void*)C,
+          1, 1, 1, LOOP_JIK, WEIGHT_STATIONARY, NULL, PIXELS, NULL, RELU, 0, 0, 1);
+    }
+
+    for (size_t i = 0; i < MAT_DIM_I; i++)
+      for (size_t j = 0; j < MAT_DIM_J; j++)
+        if (C[i / PIXELS][j][i % PIXELS] != gold[i][j]) {
+          printf("Matmul is incorrect at (%lu, %lu): %d != %d\n",
+              i, j, C[i / PIXELS][j][i % PIXELS], gold[i][j]);
+          exit(1);
+        }
+  }
+
+  exit(0);
+}
+
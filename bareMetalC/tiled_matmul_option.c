@@ -98,7 +98,7 @@ int main() {
         for (int relu6_shift = 0; relu6_shift <= 1; relu6_shift += 1) {
           for (int no_bias = 0; no_bias <= 1; no_bias += 1) {
 #else
-  for (enum tiled_matmul_type_t option = OS; option <= CPU; option++) {
+  for (enum tiled_matmul_type_t option = OS; option <= AUTO; option++) {
     for (int activation = 0; activation <= 2; activation++) {
       for (int shift = 0; shift <= 12; shift += 6) {
         for (int relu6_shift = 0; relu6_shift <= 6; relu6_shift += 3) {
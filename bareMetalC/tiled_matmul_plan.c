@@ -0,0 +1,85 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// Layer shapes (I, J, K) taken from the resnet, mobilenet and mlp workloads
+static const size_t shapes[][3] = {
+  {16, 16, 16},
+  {12544, 64, 576},
+  {64, 2560, 832},
+  {64, 10, 800},
+  {3136, 256, 64},
+  {49, 1000, 2048},
+};
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+    const size_t I = shapes[s][0], J = shapes[s][1], K = shapes[s][2];
+
+    for (enum tiled_matmul_type_t option = OS; option <= AUTO; option++) {
+      if (option == CPU)
+        continue;
+
+      for (int no_bias = 0; no_bias <= 1; no_bias++) {
+        struct tiled_matmul_plan_t plan = tiled_matmul_plan(I, J, K,
+            no_bias, 1, option);
+
+        printf("%lux%lux%lu: ", I, J, K);
+        print_tiled_matmul_plan(&plan);
+
+        // AUTO has to settle on one of the other options
+        if (option == AUTO) {
+          if (plan.dataflow == AUTO) {
+            printf("AUTO plan didn't pick a dataflow\n");
+            exit(1);
+          } else if (plan.dataflow == CPU) {
+            continue;
+          }
+        }
+
+        // The plan has to fit in one ping-pong buffer of the scratchpad and
+        // of the accumulator
+        if ((option != AUTO && plan.dataflow != option) ||
+            plan.tile_i == 0 || plan.tile_j == 0 || plan.tile_k == 0 ||
+            !sp_tiles_fit_double_buffered(plan.tile_i, plan.tile_j, plan.tile_k) ||
+            plan.tile_i * plan.tile_j * DIM > ACC_BUFFER_ROWS) {
+          printf("Plan doesn't fit in the scratchpad or accumulator\n");
+          exit(1);
+        }
+
+        // Every matrix has to be moved at least once, and moving one block at
+        // a time can never be better than the plan
+        struct tiled_matmul_plan_t smallest = { .tile_i = 1, .tile_j = 1,
+          .tile_k = 1, .dataflow = plan.dataflow };
+        tiled_matmul_plan_cost(I, J, K, no_bias, 1, &smallest);
+
+        const size_t min_bytes = (I*K + K*J + I*J) * sizeof(elem_t) +
+          (no_bias ? 0 : I*J*sizeof(acc_t));
+
+        if (tiled_matmul_plan_bytes(&plan) < min_bytes ||
+            tiled_matmul_plan_bytes(&plan) > tiled_matmul_plan_bytes(&smallest)) {
+          printf("Plan's traffic is out of bounds\n");
+          exit(1);
+        }
+      }
+    }
+  }
+
+  exit(0);
+}
+
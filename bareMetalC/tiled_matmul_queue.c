@@ -0,0 +1,93 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// Every call to sp_tiled_matmul issues more than MAX_Q_LEN preloads and
+// computes, and each call but the first needs a new B tile
+#define TILE_I 4
+#define TILE_J 4
+#define TILE_K 16
+
+#define MAT_DIM_I (TILE_I*DIM)
+#define MAT_DIM_K (TILE_K*DIM)
+#ifndef BAREMETAL
+#define MAT_DIM_J (8*TILE_J*DIM)
+#else
+#define MAT_DIM_J (3*TILE_J*DIM)
+#endif
+
+#if 2*TILE_I*TILE_K*DIM <= MAX_Q_LEN
+#error tiles are too small to fill the execute queue
+#endif
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t A[MAT_DIM_I][MAT_DIM_K] row_align(1);
+  static elem_t B[MAT_DIM_K][MAT_DIM_J] row_align(1);
+  static acc_t D[MAT_DIM_I][MAT_DIM_J] row_align_acc(1);
+  static elem_t C[MAT_DIM_I][MAT_DIM_J] row_align(1);
+  static elem_t gold[MAT_DIM_I][MAT_DIM_J];
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t k = 0; k < MAT_DIM_K; k++)
+      A[i][k] = (rand() % 3) - 1;
+
+  for (size_t k = 0; k < MAT_DIM_K; k++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      B[k][j] = (rand() % 3) - 1;
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      D[i][j] = (rand() % 3) - 1;
+
+  matmul_cpu(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, gold,
+      RELU, 0, 0, 1);
+
+  for (enum tiled_matmul_type_t dataflow = OS; dataflow <= WS; dataflow++) {
+    matmul_queue_stats = (struct matmul_queue_stats_t) { .issued = {0} };
+
+    if (dataflow == OS)
+      tiled_matmul_os(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, C,
+          TILE_I, TILE_J, TILE_K, LOOP_IJK, RELU, 0, 0, 1);
+    else
+      tiled_matmul_ws(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, C,
+          TILE_I, TILE_J, TILE_K, LOOP_IJK, RELU, 0, 0, 1);
+
+    print_matmul_queue_stats();
+
+    for (size_t i = 0; i < MAT_DIM_I; i++)
+      for (size_t j = 0; j < MAT_DIM_J; j++)
+        if (C[i][j] != gold[i][j]) {
+          printf("Matmul is incorrect at (%lu, %lu): %d != %d\n",
+              i, j, C[i][j], gold[i][j]);
+          exit(1);
+        }
+
+    // The next tile's B is moved in during the current tile's computes, so
+    // only the last call, which has nothing to move in early, should issue
+    // more than MAX_Q_LEN execute commands in a row
+    if (matmul_queue_stats.full_runs[EXECUTE_QUEUE] > 1) {
+      printf("Execute queue was filled without any move-ins in between\n");
+      exit(1);
+    }
+  }
+
+  exit(0);
+}
+
@@ -0,0 +1,132 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// I, J, K, residual columns, residual row length, residual shift, shift.
+// These cover residuals as wide as the output and narrower than it, with
+// rows longer than they are, dimensions which aren't multiples of DIM, and a
+// residual scale which is too large to be fused. With a kernel_dim of 3, K is
+// the number of input channels of a conv over a 6x6 image instead.
+static const size_t matmuls[][7] = {
+  {72, 48, 24, 48, 48, 1, 3},
+  {36, 64, 32, 32, 80, 0, 0},
+  {33, 20, 50, 20, 20, 2, 2},
+  {20, 32, 16, 32, 32, 5, 2},
+};
+
+#define MAX_DIM 80
+
+static void check(size_t I, size_t J, elem_t C[I][J], elem_t gold[I][J],
+        const char * name, int option, int no_bias) {
+  for (size_t i = 0; i < I; i++)
+    for (size_t j = 0; j < J; j++)
+      if (C[i][j] != gold[i][j]) {
+        printf("%s with option %d, no_bias %d is incorrect at (%lu, %lu): %d != %d\n",
+            name, option, no_bias, i, j, C[i][j], gold[i][j]);
+        exit(1);
+      }
+}
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t A[MAX_DIM*MAX_DIM] row_align(1);
+  static elem_t B[9*MAX_DIM*MAX_DIM] row_align(1);
+  static acc_t D[MAX_DIM*MAX_DIM] row_align_acc(1);
+  static acc_t D_res[MAX_DIM*MAX_DIM] row_align_acc(1);
+  static elem_t R[MAX_DIM*MAX_DIM] row_align(1);
+  static elem_t C[MAX_DIM*MAX_DIM] row_align(1);
+  static elem_t gold[MAX_DIM*MAX_DIM];
+
+  for (size_t s = 0; s < sizeof(matmuls) / sizeof(matmuls[0]); s++) {
+    const size_t I = matmuls[s][0], J = matmuls[s][1], K = matmuls[s][2];
+    const size_t cols = matmuls[s][3], row_len = matmuls[s][4];
+    const int res_shift = matmuls[s][5], shift = matmuls[s][6];
+
+    const struct tiled_matmul_residual_t res = {
+      .R = R, .row_len = row_len, .cols = cols, .shift = res_shift,
+    };
+
+    for (size_t i = 0; i < 9*K*J; i++)
+      B[i] = (rand() % 5) - 2;
+
+    for (size_t i = 0; i < I*row_len; i++)
+      R[i] = (rand() % 64) - 32;
+
+    for (enum tiled_matmul_type_t option = OS; option <= HYBRID; option++) {
+      for (int no_bias = 0; no_bias <= 1; no_bias++) {
+        for (size_t i = 0; i < I*J; i++)
+          D[i] = no_bias ? 0 : (rand() % 64) - 32;
+
+        // A fused residual is the same as a bias which has the residual added
+        // to it, and one which can't be fused is added to the output after
+        const int fused = tiled_matmul_residual_fused(&res, shift);
+
+        for (size_t i = 0; i < I; i++)
+          for (size_t j = 0; j < J; j++)
+            D_res[i*J + j] = D[i*J + j] + (fused ? tiled_matmul_residual_at(&res, shift, i, j) : 0);
+
+        // A matmul
+        for (size_t i = 0; i < I*K; i++)
+          A[i] = (rand() % 5) - 2;
+
+        printf("%lux%lux%lu matmul, residual shift %d, shift %d, option %d, no_bias %d\n",
+            I, J, K, res_shift, shift, option, no_bias);
+
+        tiled_matmul_residual(I, J, K, (void*)A, (void*)B, no_bias ? NULL : D,
+            &res, (void*)C, NO_ACTIVATION, shift, 0, 1, option);
+
+        matmul_cpu(I, J, K, (void*)A, (void*)B, D_res, (void*)gold,
+            NO_ACTIVATION, shift, 0, 1);
+
+        if (!fused)
+          matmul_cpu_add_residual(I, J, &res, (void*)gold);
+
+        check(I, J, (void*)C, (void*)gold, "Matmul", option, no_bias);
+
+        // A 3x3 conv with the same output dimensions, if they're those of a
+        // batch of 6x6 images
+        if (I % 36 != 0)
+          continue;
+
+        const size_t batch_size = I / 36;
+
+        for (size_t i = 0; i < batch_size*6*6*K; i++)
+          A[i] = (rand() % 5) - 2;
+
+        printf("%lux6x6x%lu conv, residual shift %d, shift %d, option %d, no_bias %d\n",
+            batch_size, K, res_shift, shift, option, no_bias);
+
+        tiled_conv_residual(batch_size, 6, K, J, 6, 1, 1, 3,
+            (void*)A, (void*)B, no_bias ? NULL : D, &res, (void*)C,
+            RELU, shift, 0, 1, option);
+
+        conv_cpu(batch_size, 6, K, J, 6, 1, 1, 3,
+            (void*)A, (void*)B, D_res, NULL, (void*)gold,
+            RELU, shift, 0, 1);
+
+        if (!fused)
+          matmul_cpu_add_residual(I, J, &res, (void*)gold);
+
+        check(I, J, (void*)C, (void*)gold, "Conv", option, no_bias);
+      }
+    }
+  }
+
+  exit(0);
+}
@@ -0,0 +1,69 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+#ifndef BAREMETAL
+#define MAT_DIM_I 200
+#define MAT_DIM_K 150
+#define MAT_DIM_J 100
+#else
+#define MAT_DIM_I 50
+#define MAT_DIM_K 40
+#define MAT_DIM_J 30
+#endif
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  static elem_t A[MAT_DIM_I][MAT_DIM_K] row_align(1);
+  static elem_t B[MAT_DIM_K][MAT_DIM_J] row_align(1);
+  static acc_t D[MAT_DIM_I][MAT_DIM_J] row_align_acc(1);
+  static elem_t C[MAT_DIM_I][MAT_DIM_J] row_align(1);
+  static elem_t gold[MAT_DIM_I][MAT_DIM_J];
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t k = 0; k < MAT_DIM_K; k++)
+      A[i][k] = (rand() % 3) - 1;
+
+  for (size_t k = 0; k < MAT_DIM_K; k++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      B[k][j] = (rand() % 3) - 1;
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      D[i][j] = (rand() % 3) - 1;
+
+  printf("Tuning\n");
+  tiled_matmul_tune(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, NULL, C,
+      RELU, 0, 0, 1);
+
+  printf("Starting CPU matmul\n");
+  matmul_cpu(MAT_DIM_I, MAT_DIM_J, MAT_DIM_K, A, B, D, gold,
+      RELU, 0, 0, 1);
+
+  for (size_t i = 0; i < MAT_DIM_I; i++)
+    for (size_t j = 0; j < MAT_DIM_J; j++)
+      if (C[i][j] != gold[i][j]) {
+        printf("Tuned matmul is incorrect at (%lu, %lu): %d != %d\n",
+            i, j, C[i][j], gold[i][j]);
+        exit(1);
+      }
+
+  exit(0);
+}
+
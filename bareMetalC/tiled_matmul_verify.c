@@ -0,0 +1,166 @@
+// See LICENSE for license details.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifndef BAREMETAL
+#include <sys/mman.h>
+#endif
+#include "include/gemmini.h"
+
+// I, J, K, residual shift (-1 for none), shift.
+// These cover dimensions which aren't multiples of DIM, outputs which
+// saturate, and residuals which are fused and which aren't.
+static const size_t matmuls[][5] = {
+  {100, 70, 50, -1, 6},
+  {64, 48, 128, 2, 4},
+  {37, 29, 300, 8, 3},
+  {32, 32, 16, -1, 0},
+};
+
+#define MAX_DIM 128
+#define MAX_K 300
+
+static elem_t A[MAX_DIM*MAX_K] row_align(1);
+static elem_t B[MAX_K*MAX_DIM] row_align(1);
+static acc_t D[MAX_DIM*MAX_DIM] row_align_acc(1);
+static elem_t R[MAX_DIM*MAX_DIM] row_align(1);
+static elem_t C[MAX_DIM*MAX_DIM] row_align(1);
+
+// Flips the low bit of some outputs one at a time, and checks that every
+// flip is caught
+static void check_faults(size_t I, size_t J, size_t K,
+        const struct tiled_matmul_residual_t * res, int act, int shift,
+        int full_bias_width, const char * name) {
+  for (int f = 0; f < 8; f++) {
+    const size_t i = rand() % I, j = rand() % J;
+    C[i*J + j] ^= 1;
+
+    if (tiled_matmul_verify(I, J, K, (void*)A, (void*)B, D, res, (void*)C,
+          act, shift, 0, full_bias_width)) {
+      printf("%s: fault at (%lu, %lu) wasn't caught\n", name, i, j);
+      exit(1);
+    }
+
+    C[i*J + j] ^= 1;
+  }
+}
+
+int main() {
+#ifndef BAREMETAL
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      perror("mlockall failed");
+      exit(1);
+    }
+#endif
+
+  matmul_flush(0);
+
+  for (size_t s = 0; s < sizeof(matmuls) / sizeof(matmuls[0]); s++) {
+    const size_t I = matmuls[s][0], J = matmuls[s][1], K = matmuls[s][2];
+    const int res_shift = matmuls[s][3], shift = matmuls[s][4];
+
+    const struct tiled_matmul_residual_t residual = {
+      .R = R, .row_len = J, .cols = J, .shift = res_shift,
+    };
+    const struct tiled_matmul_residual_t * res = res_shift < 0 ? NULL : &residual;
+
+    for (size_t i = 0; i < I*K; i++)
+      A[i] = (rand() % 16) - 8;
+    for (size_t i = 0; i < K*J; i++)
+      B[i] = (rand() % 16) - 8;
+    for (size_t i = 0; i < I*J; i++) {
+      D[i] = (rand() % 256) - 128;
+      R[i] = (rand() % 256) - 128;
+    }
+
+    for (enum tiled_matmul_type_t option = OS; option <= CPU; option++) {
+      for (int act = NO_ACTIVATION; act <= RELU6; act++) {
+        for (int no_bias = 0; no_bias <= 1; no_bias++) {
+          printf("%lux%lux%lu, residual shift %d, shift %d, option %d, act %d, no_bias %d\n",
+              I, J, K, res_shift, shift, option, act, no_bias);
+
+          tiled_matmul_residual(I, J, K, (void*)A, (void*)B, no_bias ? NULL : D,
+              res, (void*)C, act, shift, 0, 1, option);
+
+          if (!tiled_matmul_verify(I, J, K, (void*)A, (void*)B, no_bias ? NULL : D,
+                res, (void*)C, act, shift, 0, 1)) {
+            printf("Correct output failed verification\n");
+            exit(1);
+          }
+        }
+      }
+    }
+  }
+
+  // Without a shift, activation or saturation, the checksums are exact, so
+  // they catch every fault, in any tile
+  {
+    const size_t I = 100, J = 70, K = 20;
+
+    for (size_t i = 0; i < I*K; i++)
+      A[i] = (rand() % 3) - 1;
+    for (size_t i = 0; i < K*J; i++)
+      B[i] = (rand() % 3) - 1;
+    for (size_t i = 0; i < I*J; i++)
+      D[i] = (rand() % 64) - 32;
+
+    tiled_matmul_residual(I, J, K, (void*)A, (void*)B, D, NULL, (void*)C,
+        NO_ACTIVATION, 0, 0, 1, OS);
+    check_faults(I, J, K, NULL, NO_ACTIVATION, 0, 1, "Checksums");
+  }
+
+  // With no more tiles than are sampled, every tile is recomputed, so faults
+  // which the rounding hides from the checksums are caught too
+  {
+    const size_t I = 32, J = 32, K = 64;
+    const int shift = 6;
+
+    for (size_t i = 0; i < I*K; i++)
+      A[i] = (rand() % 16) - 8;
+    for (size_t i = 0; i < K*J; i++)
+      B[i] = (rand() % 16) - 8;
+
+    tiled_matmul_residual(I, J, K, (void*)A, (void*)B, NULL, NULL, (void*)C,
+        NO_ACTIVATION, shift, 0, 1, OS);
+    check_faults(I, J, K, NULL, NO_ACTIVATION, shift, 1, "Sampled tiles");
+  }
+
+  // RELU hides outputs which are pushed down to 0 from the checksums, so
+  // zeroing a column's positive outputs is left to the rows which are rerun
+  // without activation
+  {
+    const size_t I = 100, J = 70, K = 20;
+    static elem_t saved[MAX_DIM];
+
+    for (size_t i = 0; i < I*K; i++)
+      A[i] = (rand() % 3) - 1;
+    for (size_t i = 0; i < K*J; i++)
+      B[i] = (rand() % 3) - 1;
+    for (size_t i = 0; i < I*J; i++)
+      D[i] = (rand() % 64) - 32;
+
+    tiled_matmul_residual(I, J, K, (void*)A, (void*)B, D, NULL, (void*)C,
+        RELU, 0, 0, 1, OS);
+
+    for (size_t j = 0; j < J; j += 7) {
+      for (size_t i = 0; i < I; i++) {
+        saved[i] = C[i*J + j];
+        C[i*J + j] = 0;
+      }
+
+      if (tiled_matmul_verify(I, J, K, (void*)A, (void*)B, D, NULL, (void*)C,
+            RELU, 0, 0, 1)) {
+        printf("RELU: zeroed column %lu wasn't caught\n", j);
+        exit(1);
+      }
+
+      for (size_t i = 0; i < I; i++)
+        C[i*J + j] = saved[i];
+    }
+  }
+
+  exit(0);
+}
@@ -5,8 +5,13 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <limits.h>
+#ifndef BAREMETAL
+#include <pthread.h>
+#include <unistd.h>
+#endif
 // TODO use stdbool.h as well
 
 #include "include/gemmini_params.h"
@@ -52,34 +57,167 @@ void matadd(int64_t sum[DIM][DIM], int64_t m1[DIM][DIM], int64_t m2[DIM][DIM]) {
         (((shift) == 0 ? 0 : (((x) >> ((shift)-1)) & 1)) & \
              ((((shift) <= 1 ? 0 : ((x) & ((1 << ((shift)-1)) - 1))) != 0) | (((x) >> (shift)) & 1)));})
 
+// SIMD element-wise ops
+//
+// The element-wise passes over activations are written on GCC's vector
+// extensions, which compile to SSE/AVX or NEON on hosts, and to vector or
+// packed-SIMD instructions on RISC-V cores which have them. Every element
+// after the last whole vector goes through the scalar loop.
+// GEMMINI_SIMD_BYTES is the width of the vectors. If it's 0, everything goes
+// through the scalar loops, which is the default on targets without SIMD,
+// where GCC would split every vector op back into scalar ones.
+#ifndef GEMMINI_SIMD_BYTES
+#if defined(__GNUC__) && (defined(__SSE2__) || defined(__ARM_NEON) || \
+    defined(__riscv_vector) || defined(__riscv_p))
+#define GEMMINI_SIMD_BYTES 16
+#else
+#define GEMMINI_SIMD_BYTES 0
+#endif
+#endif
+
+#if GEMMINI_SIMD_BYTES > 0
+
+#define SIMD_LANES (GEMMINI_SIMD_BYTES / sizeof(elem_t))
+
+typedef elem_t elem_vec_t __attribute__((vector_size(GEMMINI_SIMD_BYTES)));
+typedef acc_t acc_vec_t __attribute__((vector_size(SIMD_LANES * sizeof(acc_t))));
+typedef int64_t full_vec_t __attribute__((vector_size(SIMD_LANES * sizeof(int64_t))));
+typedef uint8_t byte_vec_t __attribute__((vector_size(GEMMINI_SIMD_BYTES)));
+
+// Lanes of a comparison's mask are all ones where it's true
+#define SIMD_SELECT(mask, a, b) (((a) & (mask)) | ((b) & ~(mask)))
+
+// ROUNDING_RIGHT_SHIFT on every lane of a vector of acc_t's or int64_t's
+#define SIMD_ROUNDING_RIGHT_SHIFT(x, shift) \
+    ({__typeof__(x) _x = (x), _q = _x >> (shift); \
+      (shift) == 0 ? _x : _q + (((_x >> ((shift)-1)) & 1) & \
+        ((((_x & ((1 << ((shift)-1)) - 1)) != 0) & 1) | (_q & 1)));})
+
+// Saturates a vector of acc_t's or int64_t's to [lo, hi], within elem_t's
+// range, and narrows it to elem_t's
+#define SIMD_NARROW(x, lo, hi) \
+    ({__typeof__(x) _v = (x); \
+      _v = SIMD_SELECT(_v < (lo), _v * 0 + (lo), _v); \
+      _v = SIMD_SELECT(_v > (hi), _v * 0 + (hi), _v); \
+      __builtin_convertvector(_v, elem_vec_t);})
+
+#endif
+
+// Clamps n elements to [lo, hi]
+static void __attribute__((unused)) simd_clamp(size_t n, const elem_t * in,
+        elem_t * out, elem_t lo, elem_t hi) {
+  size_t i = 0;
+
+#if GEMMINI_SIMD_BYTES > 0
+  const elem_vec_t lo_v = (elem_vec_t){0} + lo, hi_v = (elem_vec_t){0} + hi;
+
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    elem_vec_t v;
+    memcpy(&v, in + i, sizeof(v));
+    v = SIMD_SELECT(v < lo_v, lo_v, v);
+    v = SIMD_SELECT(v > hi_v, hi_v, v);
+    memcpy(out + i, &v, sizeof(v));
+  }
+#endif
+
+  for (; i < n; i++)
+    out[i] = in[i] < lo ? lo : (in[i] > hi ? hi : in[i]);
+}
+
+// Scales n int64_t's down to elem_t's with a rounding shift, saturating them
+static void __attribute__((unused)) simd_shift_full(size_t n, const int64_t * in,
+        elem_t * out, int shift) {
+  size_t i = 0;
+
+#if GEMMINI_SIMD_BYTES > 0
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    full_vec_t v;
+    memcpy(&v, in + i, sizeof(v));
+    v = SIMD_ROUNDING_RIGHT_SHIFT(v, shift);
+    const elem_vec_t e = SIMD_NARROW(v, (int64_t)elem_t_min, (int64_t)elem_t_max);
+    memcpy(out + i, &e, sizeof(e));
+  }
+#endif
+
+  // The tail is bounded by its own length, rather than by n, so that GCC
+  // doesn't try to reason about it running on past the vectorised prefix
+  const size_t tail = n - i;
+  in += i;
+  out += i;
+
+  for (size_t t = 0; t < tail; t++) {
+    const int64_t shifted = ROUNDING_RIGHT_SHIFT(in[t], shift);
+    out[t] = shifted > elem_t_max ? elem_t_max : (shifted < elem_t_min ? elem_t_min : shifted);
+  }
+}
+
+// Adds n elements of R, scaled down by a rounding shift, to C, saturating the
+// sums, like Gemmini's vecadd with an A_shift
+static void __attribute__((unused)) simd_add_shifted(size_t n, const elem_t * R,
+        int shift, elem_t * C) {
+  size_t i = 0;
+
+#if GEMMINI_SIMD_BYTES > 0
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    elem_vec_t r, c;
+    memcpy(&r, R + i, sizeof(r));
+    memcpy(&c, C + i, sizeof(c));
+    acc_vec_t sum = SIMD_ROUNDING_RIGHT_SHIFT(__builtin_convertvector(r, acc_vec_t), shift) +
+      __builtin_convertvector(c, acc_vec_t);
+    c = SIMD_NARROW(sum, (acc_t)elem_t_min, (acc_t)elem_t_max);
+    memcpy(C + i, &c, sizeof(c));
+  }
+#endif
+
+  for (; i < n; i++) {
+    const acc_t sum = ROUNDING_RIGHT_SHIFT((acc_t)R[i], shift) + C[i];
+    C[i] = sum > elem_t_max ? elem_t_max : (sum < elem_t_min ? elem_t_min : sum);
+  }
+}
+
+// Whether the bytes of x and y are the same, which for integer elements is
+// whether the elements are
+static int __attribute__((unused)) simd_equal(size_t bytes, const void * x,
+        const void * y) {
+  const uint8_t * const a = x, * const b = y;
+  size_t i = 0;
+
+#if GEMMINI_SIMD_BYTES > 0
+  byte_vec_t diff = {0};
+
+  for (; i + GEMMINI_SIMD_BYTES <= bytes; i += GEMMINI_SIMD_BYTES) {
+    byte_vec_t va, vb;
+    memcpy(&va, a + i, sizeof(va));
+    memcpy(&vb, b + i, sizeof(vb));
+    diff |= va ^ vb;
+  }
+
+  for (size_t l = 0; l < GEMMINI_SIMD_BYTES; l++)
+    if (diff[l] != 0)
+      return 0;
+#endif
+
+  for (; i < bytes; i++)
+    if (a[i] != b[i])
+      return 0;
+
+  return 1;
+}
+
 // THIS IS A ROUNDING SHIFT! It also performs a saturating cast
 void matshift(int64_t full[DIM][DIM], elem_t out[DIM][DIM], int shift) {
-  for (size_t r = 0; r < DIM; r++)
-    for (size_t c = 0; c < DIM; c++) {
-      // Bitshift and round element
-      int64_t shifted = ROUNDING_RIGHT_SHIFT(full[r][c], shift);
-
-      // Saturate and cast element
-      int64_t elem = shifted > elem_t_max ? elem_t_max : (shifted < elem_t_min ? elem_t_min : shifted);
-      out[r][c] = elem;
-    }
+  simd_shift_full(DIM*DIM, &full[0][0], &out[0][0], shift);
 }
 
 void matrelu(elem_t in[DIM][DIM], elem_t out[DIM][DIM]) {
-  for (size_t r = 0; r < DIM; r++)
-    for (size_t c = 0; c < DIM; c++)
-      out[r][c] = in[r][c] > 0 ? in[r][c] : 0;
+  simd_clamp(DIM*DIM, &in[0][0], &out[0][0], 0, elem_t_max);
 }
 
 void matrelu6(elem_t in[DIM][DIM], elem_t out[DIM][DIM], int scale) {
   // int max = 6;
   int max = 6 * scale;
 
-  for (size_t r = 0; r < DIM; r++)
-    for (size_t c = 0; c < DIM; c++) {
-      elem_t positive = in[r][c] > 0 ? in[r][c] : 0;
-      out[r][c] = positive > max ? max : positive;
-    }
+  simd_clamp(DIM*DIM, &in[0][0], &out[0][0], 0, max > elem_t_max ? elem_t_max : max);
 }
 
 void transpose(elem_t in[DIM][DIM], elem_t out[DIM][DIM]) {
@@ -97,22 +235,15 @@ void printMatrix(elem_t m[DIM][DIM]) {
 }
 
 int is_equal(elem_t x[DIM][DIM], elem_t y[DIM][DIM]) {
-  for (size_t i = 0; i < DIM; ++i)
-    for (size_t j = 0; j < DIM; ++j)
-      if (x[i][j] != y[i][j])
-          return 0;
-  return 1;
+  return simd_equal(sizeof(elem_t[DIM][DIM]), x, y);
 }
 
-// This is a GNU extension known as statment expressions
+// This is a GNU extension known as statment expressions. Each row is compared
+// separately, since the rows of x and y may be longer than dim_j.
 #define MAT_IS_EQUAL(dim_i, dim_j, x, y) \
     ({int result = 1; \
-      for (size_t i = 0; i < dim_i; i++) \
-        for (size_t j = 0; j < dim_j; ++j) \
-          if (x[i][j] != y[i][j]) { \
-            result = 0; \
-            break; \
-          } \
+      for (size_t i = 0; i < dim_i && result; i++) \
+        result = simd_equal((dim_j) * sizeof(x[0][0]), &x[i][0], &y[i][0]); \
       result;})
 
 int rand() {
@@ -130,6 +261,12 @@ unsigned long read_cycles() {
 // Accelerator interface
 #include "rocc-software/src/xcustom.h"
 
+// Gemmini generators which can't move out several blocks in one mvout don't
+// define MAX_BLOCK_LEN_ST
+#ifndef MAX_BLOCK_LEN_ST
+#define MAX_BLOCK_LEN_ST 1
+#endif
+
 #define k_CONFIG 0
 #define k_MVIN 2
 #define k_MVOUT 3
@@ -155,695 +292,3747 @@ unsigned long read_cycles() {
 #define ROCC_INSTRUCTION_RS1_RS2(x, rs1, rs2, funct) \
   ROCC_INSTRUCTION_0_R_R(x, rs1, rs2, funct, 10, 11)
 
+// Gemmini splits the commands it's sent between a load, an execute and a store
+// queue, each MAX_Q_LEN deep. The core can't see how full they are, but a run
+// of more than MAX_Q_LEN commands to one queue, with nothing issued to the
+// others in between, fills that queue unless it drains as fast as the core
+// issues, and leaves the other queues with nothing new to do. We count the
+// commands issued to each queue, and how often such runs happen.
+enum matmul_queue_t {LOAD_QUEUE, EXECUTE_QUEUE, STORE_QUEUE};
+
+struct matmul_queue_stats_t {
+  size_t issued[3];
+  size_t longest_run[3];
+  size_t full_runs[3];
+  enum matmul_queue_t last;
+  size_t run;
+};
+
+static struct matmul_queue_stats_t matmul_queue_stats;
+
+static inline void matmul_queue_issue(enum matmul_queue_t q) {
+  struct matmul_queue_stats_t * const s = &matmul_queue_stats;
+
+  s->issued[q]++;
+  s->run = s->last == q ? s->run + 1 : 1;
+  s->last = q;
+
+  if (s->run > s->longest_run[q])
+    s->longest_run[q] = s->run;
+  if (s->run == MAX_Q_LEN + 1)
+    s->full_runs[q]++;
+}
+
+static void __attribute__((unused)) print_matmul_queue_stats() {
+  const char * names[] = {"load", "execute", "store"};
+
+  for (int q = LOAD_QUEUE; q <= STORE_QUEUE; q++)
+    printf("%s queue: %lu commands, longest run: %lu, runs over %d: %lu\n",
+        names[q], matmul_queue_stats.issued[q], matmul_queue_stats.longest_run[q],
+        MAX_Q_LEN, matmul_queue_stats.full_runs[q]);
+}
+
+// Commands on whole DIM x DIM blocks use the original operand encoding: a
+// mvin or a block mvout takes the number of blocks it moves in the bits above
+// the scratchpad address, and every other command only takes addresses.
+//
+// Gemmini generators which define HAS_EXTENDED_DIMS in gemmini_params.h also
+// accept commands on partial blocks, which take the number of columns and
+// rows of the operands they touch in bits [47:32] and [63:48] of rs1/rs2
+// respectively. A rows field of 0 means the original encoding. This lets the
+// tiling functions handle matrices whose dimensions aren't multiples of DIM:
+//   * mvin/mvout only move "rows" rows of "cols" columns. For a block mvin or
+//     mvout, "cols" counts the columns of all the blocks together.
+//   * compute/preload treat operand elements outside of their rows and cols as
+//     zeros, and only write the first C_rows x C_cols elements of the output.
+// Without HAS_EXTENDED_DIMS, partial blocks are moved in and out through
+// zero-padded staging blocks instead, and computed on as whole blocks. See
+// matmul_staged_mvin.
+#define MATMUL_ADDR_DIMS(addr, cols, rows) \
+  (((uint64_t)(rows) << (ADDR_LEN + 16)) | ((uint64_t)(cols) << ADDR_LEN) | (uint64_t)(uint32_t)(addr))
+
+#define MATMUL_ADDR_BLOCKS(addr, len) \
+  (((uint64_t)(len) << ADDR_LEN) | (uint64_t)(uint32_t)(addr))
+
+// A single-block mvout only takes its address
+#define MATMUL_MVOUT_ADDR(addr, len) \
+  ((len) == 1 ? (uint64_t)(uint32_t)(addr) : MATMUL_ADDR_BLOCKS(addr, len))
+
+#ifdef HAS_EXTENDED_DIMS
+#define MATMUL_OPERAND(addr, cols, rows) \
+  ((cols) == DIM && (rows) == DIM ? (uint64_t)(addr) : MATMUL_ADDR_DIMS(addr, cols, rows))
+
+#define matmul_partial_mvin(dram_addr, spad_addr, cols, rows) \
+  do { \
+    matmul_queue_issue(LOAD_QUEUE); \
+    ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, dram_addr, MATMUL_ADDR_DIMS(spad_addr, cols, rows), k_MVIN); \
+  } while (0)
+
+#define matmul_partial_mvout(dram_addr, spad_addr, cols, rows) \
+  do { \
+    matmul_queue_issue(STORE_QUEUE); \
+    ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, dram_addr, MATMUL_ADDR_DIMS(spad_addr, cols, rows), k_MVOUT); \
+  } while (0)
+#else
+#define MATMUL_OPERAND(addr, cols, rows) ((void)(cols), (void)(rows), (uint64_t)(addr))
+
+#define matmul_partial_mvin(dram_addr, spad_addr, cols, rows) \
+  matmul_staged_mvin(dram_addr, spad_addr, cols, rows)
+
+#define matmul_partial_mvout(dram_addr, spad_addr, cols, rows) \
+  matmul_staged_mvout(dram_addr, spad_addr, cols, rows)
+#endif
+
 // mvin and mvout
+#define matmul_extended_mvin(dram_addr, spad_addr, cols, rows) \
+  do { \
+    if ((rows) == DIM && (cols) % DIM == 0) { \
+      matmul_queue_issue(LOAD_QUEUE); \
+      ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, dram_addr, MATMUL_ADDR_BLOCKS(spad_addr, (cols) / DIM), k_MVIN); \
+    } else { \
+      matmul_partial_mvin(dram_addr, spad_addr, cols, rows); \
+    } \
+  } while (0)
+
 #define matmul_mvin(dram_addr, spad_addr) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, dram_addr, ((uint64_t)1 << ADDR_LEN) | (spad_addr), k_MVIN)
+  matmul_extended_mvin(dram_addr, spad_addr, DIM, DIM)
 
 #define matmul_block_mvin(dram_addr, spad_addr, len) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, dram_addr, ((uint64_t)(len) << ADDR_LEN) | (spad_addr), k_MVIN)
+  matmul_extended_mvin(dram_addr, spad_addr, (len) * DIM, DIM)
+
+#define matmul_extended_mvout(dram_addr, spad_addr, cols, rows) \
+  do { \
+    if ((rows) == DIM && (cols) % DIM == 0) { \
+      matmul_queue_issue(STORE_QUEUE); \
+      ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, dram_addr, MATMUL_MVOUT_ADDR(spad_addr, (cols) / DIM), k_MVOUT); \
+    } else { \
+      matmul_partial_mvout(dram_addr, spad_addr, cols, rows); \
+    } \
+  } while (0)
 
 #define matmul_mvout(dram_addr, spad_addr) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, dram_addr, spad_addr, k_MVOUT)
+  matmul_extended_mvout(dram_addr, spad_addr, DIM, DIM)
+
+#define matmul_block_mvout(dram_addr, spad_addr, len) \
+  matmul_extended_mvout(dram_addr, spad_addr, (len) * DIM, DIM)
 
 // compute
+#define matmul_extended_compute_preloaded(A, BD, A_cols, A_rows, BD_cols, BD_rows) \
+  do { \
+    matmul_queue_issue(EXECUTE_QUEUE); \
+    ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, MATMUL_OPERAND(A, A_cols, A_rows), MATMUL_OPERAND(BD, BD_cols, BD_rows), k_COMPUTE_PRELOADED); \
+  } while (0)
+
+#define matmul_extended_compute_accumulated(A, BD, A_cols, A_rows, BD_cols, BD_rows) \
+  do { \
+    matmul_queue_issue(EXECUTE_QUEUE); \
+    ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, MATMUL_OPERAND(A, A_cols, A_rows), MATMUL_OPERAND(BD, BD_cols, BD_rows), k_COMPUTE_ACCUMULATE); \
+  } while (0)
+
 #define matmul_compute_preloaded(A, BD) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, A, BD, k_COMPUTE_PRELOADED)
+  matmul_extended_compute_preloaded(A, BD, DIM, DIM, DIM, DIM)
 
 #define matmul_compute_accumulated(A, BD) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, A, BD, k_COMPUTE_ACCUMULATE)
+  matmul_extended_compute_accumulated(A, BD, DIM, DIM, DIM, DIM)
 
 // preload
+#define matmul_extended_preload(BD, C, BD_cols, BD_rows, C_cols, C_rows) \
+  do { \
+    matmul_queue_issue(EXECUTE_QUEUE); \
+    ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, MATMUL_OPERAND(BD, BD_cols, BD_rows), MATMUL_OPERAND(C, C_cols, C_rows), k_PRELOAD); \
+  } while (0)
+
 #define matmul_preload(BD, C) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, BD, C, k_PRELOAD)
+  matmul_extended_preload(BD, C, DIM, DIM, DIM, DIM)
 
 #define matmul_preload_zeros(C) \
   matmul_preload(GARBAGE_ADDR, C)
 
 // config
+// The last value written to each of the CONFIG_EX, CONFIG_LD and CONFIG_ST
+// registers. A CONFIG command which wouldn't change its register is dropped
+// instead of taking up an issue slot and a queue entry. The cache assumes
+// nothing else reconfigures Gemmini behind our back, and starts out (and is
+// reset by matmul_flush) with every register unknown. Compile with
+// -DGEMMINI_NO_CONFIG_CACHE to issue every CONFIG command.
+struct matmul_config_cache_t {
+  uint64_t rs1[3], rs2[3];
+  int valid[3];
+  size_t issued, suppressed;
+};
+
+static struct matmul_config_cache_t matmul_config_cache;
+
+static inline void matmul_config(uint64_t rs1, uint64_t rs2) {
+  struct matmul_config_cache_t * const c = &matmul_config_cache;
+  const int reg = rs1 & 3;
+
+#ifndef GEMMINI_NO_CONFIG_CACHE
+  if (c->valid[reg] && c->rs1[reg] == rs1 && c->rs2[reg] == rs2) {
+    c->suppressed++;
+    return;
+  }
+#endif
+
+  // CONFIG_EX, CONFIG_LD and CONFIG_ST go to the execute, load and store
+  // queues respectively
+  const enum matmul_queue_t queues[] = {EXECUTE_QUEUE, LOAD_QUEUE, STORE_QUEUE};
+  matmul_queue_issue(queues[reg]);
+  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, rs1, rs2, k_CONFIG);
+
+  c->rs1[reg] = rs1;
+  c->rs2[reg] = rs2;
+  c->valid[reg] = 1;
+  c->issued++;
+}
+
+static inline void matmul_config_cache_invalidate() {
+  for (int reg = CONFIG_EX; reg <= CONFIG_ST; reg++)
+    matmul_config_cache.valid[reg] = 0;
+}
+
+static void __attribute__((unused)) print_matmul_config_cache() {
+  printf("CONFIG commands issued: %lu, suppressed: %lu\n",
+      matmul_config_cache.issued, matmul_config_cache.suppressed);
+}
+
 #define matmul_config_ex(mode, act, sys_shift, acc_shift, relu6_shift) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, ((uint64_t)(acc_shift) << 32) | ((act) << 3) | ((mode) << 2) | CONFIG_EX, ((uint64_t)(relu6_shift) << 32) | (sys_shift), k_CONFIG)
+  matmul_config(((uint64_t)(acc_shift) << 32) | ((act) << 3) | ((mode) << 2) | CONFIG_EX, ((uint64_t)(relu6_shift) << 32) | (sys_shift))
 
 #define matmul_config_ld(stride) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, CONFIG_LD, stride, k_CONFIG)
+  matmul_config(CONFIG_LD, stride)
 
 #define matmul_config_st(stride) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, CONFIG_ST, stride, k_CONFIG)
+  matmul_config(CONFIG_ST, stride)
 
 // flush
 #define matmul_flush(skip) \
-  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, skip, 0, k_FLUSH)
+  do { \
+    matmul_config_cache_invalidate(); \
+    ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, skip, 0, k_FLUSH); \
+  } while (0)
 
 // fence
 #define matmul_fence() asm volatile("fence")
 
-// Tiling functions
-// static void sp_tiled_matmul_os(elem_t * A, elem_t * B, acc_t * D, elem_t * C,
-static void sp_tiled_matmul_os(elem_t * A, elem_t * B, void * D, elem_t * C,
-        size_t I, size_t J, size_t K, size_t A_row_len,
-        size_t B_row_len, size_t D_row_len, size_t C_row_len,
-        int first_mvin, int last_mvout, int no_bias, int full_bias_width) {
+#ifndef HAS_EXTENDED_DIMS
+// Without extended dims, every mvin and mvout moves DIM whole rows of whole
+// blocks. A partial block is copied by the CPU into a staging block whose
+// padding is zeroed, and moved in from there. The zeros make a compute on the
+// whole block give the same results as one on the partial block, in the rows
+// and columns which are kept. The mvins read the ring of staging blocks
+// asynchronously, so we fence before it wraps around. A partial block is
+// moved out to a staging block too, and copied into place after a fence.
+#ifndef MATMUL_STAGING_BLOCKS
+#define MATMUL_STAGING_BLOCKS 32
+#endif
+
+static uint8_t matmul_staging[MATMUL_STAGING_BLOCKS][DIM][MAX_BYTES] __attribute__((aligned(MAX_BYTES)));
+static size_t matmul_staging_block;
+
+static void matmul_staged_mvin(const void * dram_addr, uint32_t spad_addr,
+        size_t cols, size_t rows) {
+  // mvins into the accumulator move acc_t's
+  const size_t elem_size = (spad_addr >> (ADDR_LEN-1)) & 1 ? sizeof(acc_t) : sizeof(elem_t);
+  const size_t blocks = (cols + DIM - 1) / DIM;
+  const uint64_t stride = matmul_config_cache.rs2[CONFIG_LD];
+
+  if (matmul_staging_block == MATMUL_STAGING_BLOCKS) {
+    matmul_fence();
+    matmul_staging_block = 0;
+  }
 
-  const uint32_t A_sp_addr_start = 0;
-  const uint32_t B_sp_addr_start = BANK_NUM * BANK_ROWS / 2;
-  const uint32_t D_sp_addr_start = 1 << (ADDR_LEN-1);
-  const uint32_t C_sp_addr_start = 3 << (ADDR_LEN-2);
+  uint8_t (* const staging)[MAX_BYTES] = matmul_staging[matmul_staging_block++];
 
-  const int A_blocks = K <= MAX_BLOCK_LEN ? K : MAX_BLOCK_LEN;
-  const int B_blocks = J <= MAX_BLOCK_LEN ? J : MAX_BLOCK_LEN;
-  const int D_blocks_max = full_bias_width ? MAX_BLOCK_LEN_ACC : MAX_BLOCK_LEN;
-  const int D_blocks = J <= D_blocks_max ? J : D_blocks_max;
+  for (size_t r = 0; r < DIM; r++) {
+    const size_t bytes = r < rows ? cols * elem_size : 0;
+    if (bytes != 0)
+      memcpy(staging[r], (const uint8_t *)dram_addr + r*stride, bytes);
+    memset(staging[r] + bytes, 0, blocks*DIM*elem_size - bytes);
+  }
 
-  const int sizeof_bias = full_bias_width ? sizeof(acc_t) : sizeof(elem_t);
+  matmul_config_ld(MAX_BYTES);
+  matmul_queue_issue(LOAD_QUEUE);
+  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, staging, MATMUL_ADDR_BLOCKS(spad_addr, blocks), k_MVIN);
+  matmul_config_ld(stride);
+}
 
-  // Move-in D
-  if (D != NULL && !no_bias) {
-    matmul_config_ld(D_row_len * sizeof_bias);
+static void matmul_staged_mvout(void * dram_addr, uint32_t spad_addr,
+        size_t cols, size_t rows) {
+  static elem_t staging[DIM][MAX_BLOCK_LEN_ST*DIM] row_align(MAX_BLOCK_LEN_ST);
+  const size_t blocks = (cols + DIM - 1) / DIM;
+  const uint64_t stride = matmul_config_cache.rs2[CONFIG_ST];
 
-    for (size_t i = 0; i < I; i++) {
-      for (size_t j = 0; j < J; j++) {
-        void * D_dram_addr;
-        uint32_t D_sp_addr_acc = D_sp_addr_start + (i*J + j)*DIM;
-        uint32_t D_sp_addr_sp = (i*J + j)*DIM;
-
-        if (full_bias_width) {
-          acc_t * const D_ = (acc_t *) D;
-          D_dram_addr = (void*)(D_ + (i*D_row_len + j)*DIM);
-        } else {
-          elem_t * const D_ = (elem_t *) D;
-          D_dram_addr = (void*)(D_ + (i*D_row_len + j)*DIM);
-        }
+  matmul_config_st(sizeof(staging[0]));
+  matmul_queue_issue(STORE_QUEUE);
+  ROCC_INSTRUCTION_RS1_RS2(XCUSTOM_ACC, staging, MATMUL_MVOUT_ADDR(spad_addr, blocks), k_MVOUT);
+  matmul_config_st(stride);
+  matmul_fence();
 
-        int already_moved_in = j % D_blocks != 0;
+  for (size_t r = 0; r < rows; r++)
+    memcpy((uint8_t *)dram_addr + r*stride, staging[r], cols * sizeof(elem_t));
+}
+#endif
 
-        if (!already_moved_in) {
-          int blocks = j + D_blocks <= J ? D_blocks : J-j;
+// Tiling functions
 
-          if (full_bias_width) {
-            matmul_block_mvin(D_dram_addr, D_sp_addr_acc, blocks);
-          } else {
-            matmul_block_mvin(D_dram_addr, D_sp_addr_sp, blocks);
-          }
-        }
+// Scratchpad layout used by the tiling functions. A and B each get half of
+// the scratchpad. Each half is split again into two ping-pong buffers, so that
+// the mvins for the next tile can go out while the current tile is computed.
+#define SP_PARTITION_ROWS (BANK_NUM * BANK_ROWS / 2)
+#define SP_BUFFER_ROWS (SP_PARTITION_ROWS / 2)
+#define A_SP_ADDR_START 0
+#define B_SP_ADDR_START SP_PARTITION_ROWS
+
+// Output tiles alternate between the two halves of the accumulator, so that
+// one tile can be moved out while the next one is being moved in
+#define ACC_BUFFER_ROWS (ACC_ROWS / 2)
+
+// Returns whether an A tile of TILE_I x TILE_K and a B tile of TILE_K x TILE_J
+// blocks (plus the bias staging area) each fit in one half of their partition
+static int sp_tiles_fit_double_buffered(size_t TILE_I, size_t TILE_J, size_t TILE_K) {
+  return TILE_I*TILE_K*DIM <= SP_BUFFER_ROWS &&
+    TILE_K*TILE_J*DIM <= SP_BUFFER_ROWS &&
+    TILE_I*TILE_J*DIM <= SP_BUFFER_ROWS;
+}
 
-        if (!full_bias_width) {
-          matmul_preload(D_sp_addr_sp, D_sp_addr_acc);
-          matmul_compute_preloaded(GARBAGE_ADDR, GARBAGE_ADDR);
-        }
-      }
-    }
-  }
+// Order of the loops over tiles in tiled_matmul_os/ws, from outermost to
+// innermost. Whenever the innermost loop is j0, each A tile is reused by
+// consecutive calls instead of being moved in again, and likewise for B
+// tiles when the innermost loop is i0. When k0 isn't the innermost loop, the
+// output tiles of all the loops inside it stay resident in the accumulator
+// while it runs, so they have to fit in it together.
+enum tiled_matmul_loop_order_t {LOOP_IJK, LOOP_IKJ, LOOP_JIK, LOOP_JKI, LOOP_KIJ, LOOP_KJI};
 
-  /*
-  for (size_t i = 0; i < I; i++) {
-    for (size_t k = 0; k < K; k += A_blocks) {
-      elem_t * const A_dram_addr = A + (i*A_row_len + k)*DIM;
-      const uint32_t A_sp_addr = A_sp_addr_start + (i*K + k)*DIM;
+static const char tiled_matmul_loop_vars[][4] = {"ijk", "ikj", "jik", "jki", "kij", "kji"};
 
-      const int blocks = k + A_blocks <= K ? A_blocks : K-k;
+static size_t tiled_matmul_loop_trips(char var, size_t I0, size_t J0, size_t K0) {
+  return var == 'i' ? I0 : (var == 'j' ? J0 : K0);
+}
+
+// Finds the tile computed by the t'th call to sp_tiled_matmul. slot is the
+// index of its output tile among those which are resident in the accumulator
+// at the same time, and group counts how many times that set has changed.
+static void tiled_matmul_loop_index(enum tiled_matmul_loop_order_t loop_order,
+        size_t t, size_t I0, size_t J0, size_t K0,
+        size_t * i0, size_t * j0, size_t * k0, size_t * slot, size_t * group) {
+  const char * vars = tiled_matmul_loop_vars[loop_order];
+  int inside_k = 1;
+  size_t slot_stride = 1, group_stride = 1;
+
+  *i0 = *j0 = *k0 = 0;
+  *slot = 0;
+  *group = 0;
+
+  for (int l = 2; l >= 0; l--) {
+    const size_t trips = tiled_matmul_loop_trips(vars[l], I0, J0, K0);
+    const size_t idx = t % trips;
+    t /= trips;
+
+    if (vars[l] == 'i') {
+      *i0 = idx;
+    } else if (vars[l] == 'j') {
+      *j0 = idx;
+    } else {
+      *k0 = idx;
+      inside_k = 0;
+      continue;
+    }
 
-      matmul_config_ld(A_row_len * sizeof(elem_t));
-      matmul_block_mvin(A_dram_addr, A_sp_addr, blocks);
+    if (inside_k) {
+      *slot += idx * slot_stride;
+      slot_stride *= trips;
+    } else {
+      *group += idx * group_stride;
+      group_stride *= trips;
     }
   }
+}
 
-  for (size_t j = 0; j < J; j += B_blocks) {
-    for (size_t k = 0; k < K; k++) {
-        elem_t * const B_dram_addr = B + (k*B_row_len + j)*DIM;
-        const uint32_t B_sp_addr = B_sp_addr_start + (k*J + j)*DIM;
+// Accumulator address of an output tile, given its slot and group
+static uint32_t tiled_matmul_acc_addr(size_t slot, size_t group,
+        size_t acc_tile_rows, int acc_double_buffered) {
+  return (acc_double_buffered ? (group % 2) * ACC_BUFFER_ROWS : 0) +
+    slot * acc_tile_rows;
+}
 
-        const int blocks = j + B_blocks <= J ? B_blocks : J-j;
+// Number of output tiles which are resident in the accumulator at once
+static size_t tiled_matmul_loop_resident_tiles(enum tiled_matmul_loop_order_t loop_order,
+        size_t I0, size_t J0, size_t K0) {
+  const char * vars = tiled_matmul_loop_vars[loop_order];
+  size_t resident = 1;
 
-        matmul_config_ld(B_row_len * sizeof(elem_t));
-        matmul_block_mvin(B_dram_addr, B_sp_addr, blocks);
-    }
-  }
-  */
+  for (int l = 2; vars[l] != 'k'; l--)
+    resident *= tiled_matmul_loop_trips(vars[l], I0, J0, K0);
 
-  for (size_t i = 0; i < I; i++) {
-    for (size_t j = 0; j < J; j++) {
-      const uint32_t C_sp_addr = C_sp_addr_start + (i*J + j)*DIM;
+  return resident;
+}
 
-      for (size_t k = 0; k < K; k++) {
-        // printf("  i: %u, j: %u, k: %u\n", i, j, k);
+// Number of times each A and B tile is moved in, for a given loop order
+static void tiled_matmul_loop_reloads(enum tiled_matmul_loop_order_t loop_order,
+        size_t I0, size_t J0, size_t K0, size_t * A_reloads, size_t * B_reloads) {
+  const char * vars = tiled_matmul_loop_vars[loop_order];
 
-        elem_t * const A_dram_addr = A + (i*A_row_len + k)*DIM;
-        elem_t * const B_dram_addr = B + (k*B_row_len + j)*DIM;
+  // Loops which only run once don't change the tile between calls
+  int l = 2;
+  while (l >= 0 && tiled_matmul_loop_trips(vars[l], I0, J0, K0) == 1)
+    l--;
 
-        const uint32_t A_sp_addr = A_sp_addr_start + (i*K + k)*DIM;
-        const uint32_t B_sp_addr = B_sp_addr_start + (k*J + j)*DIM;
+  const char innermost = l >= 0 ? vars[l] : 0;
 
-        // Move-in A and B
-        {
-          // printf("    Enter mvin\n");
+  *A_reloads = innermost == 0 || innermost == 'j' ? 1 : J0;
+  *B_reloads = innermost == 0 || innermost == 'i' ? 1 : I0;
+}
 
-          int A_already_moved_in = j != 0 || k % A_blocks != 0;
-          int B_already_moved_in = i != 0 || j % B_blocks != 0;
+// Number of elements moved by the most recent tiled_matmul_os/ws call. A and
+// B count what was moved in, including reloads, while C counts what was moved
+// out. Dividing by the size of each matrix gives how many times it was moved.
+struct tiled_matmul_counters_t {
+  size_t A_loads, B_loads, C_stores;
+  size_t A_size, B_size, C_size;
+};
 
-          if (!A_already_moved_in) {
-            matmul_config_ld(A_row_len * sizeof(elem_t));
+static struct tiled_matmul_counters_t tiled_matmul_counters;
 
-            const int blocks = k + A_blocks <= K ? A_blocks : K-k;
-            matmul_block_mvin(A_dram_addr, A_sp_addr, blocks);
-          }
+static void __attribute__((unused)) print_tiled_matmul_counters() {
+  const struct tiled_matmul_counters_t * c = &tiled_matmul_counters;
 
-          if (!B_already_moved_in) {
-            matmul_config_ld(B_row_len * sizeof(elem_t));
+  // Reload factors are printed with two decimal places, without using floats
+  const size_t A_x100 = c->A_size ? c->A_loads * 100 / c->A_size : 0;
+  const size_t B_x100 = c->B_size ? c->B_loads * 100 / c->B_size : 0;
+  const size_t C_x100 = c->C_size ? c->C_stores * 100 / c->C_size : 0;
 
-            const int blocks = j + B_blocks <= J ? B_blocks : J-j;
-            matmul_block_mvin(B_dram_addr, B_sp_addr, blocks);
-          }
+  printf("A reloads: %lu.%02lu, B reloads: %lu.%02lu, C reloads: %lu.%02lu\n",
+      A_x100 / 100, A_x100 % 100, B_x100 / 100, B_x100 % 100,
+      C_x100 / 100, C_x100 % 100);
+}
 
-          // printf("    Exit mvin\n");
-        }
+// An output tile of I x J blocks which is still sitting in the accumulator.
+// pad_I and pad_J are the number of rows and columns missing from its last
+// row and column of blocks, when the matrix isn't a multiple of DIM.
+struct deferred_mvout_t {
+  elem_t * C;
+  uint32_t C_sp_addr_start;
+  size_t I, J, pad_I, pad_J;
+  size_t C_row_len;
+  size_t block;
+};
 
-        // Compute
-        {
-          // printf("    Enter compute\n");
-          uint32_t out_sp_addr = k == K-1 ? C_sp_addr : GARBAGE_ADDR;
+// Moves out up to MAX_BLOCK_LEN_ST blocks of one row of an output tile whose
+// move-out was deferred to the next sp_tiled call, so that it overlaps with
+// that call's move-ins
+static void sp_tiled_mvout_deferred(struct deferred_mvout_t * deferred) {
+  if (deferred == NULL || deferred->C == NULL ||
+      deferred->block >= deferred->I * deferred->J)
+    return;
 
-          // If we're not using a bias, then we want to overwrite what's in the
-          // accumulator, rather than writing over it
-          int no_bias_new_matrix = no_bias && D != NULL && k == K-1;
-          if (no_bias_new_matrix) {
-            out_sp_addr &= ~(1 << (ADDR_LEN-2));
-          }
+  const size_t i = deferred->block / deferred->J;
+  const size_t j = deferred->block % deferred->J;
 
-          matmul_preload(GARBAGE_ADDR, out_sp_addr);
+  const size_t blocks = j + MAX_BLOCK_LEN_ST <= deferred->J ?
+    MAX_BLOCK_LEN_ST : deferred->J - j;
 
-          if (k == 0) { // First iteration
-            matmul_compute_preloaded(A_sp_addr, B_sp_addr);
-          } else { // All other iterations
-            matmul_compute_accumulated(A_sp_addr, B_sp_addr);
-          }
+  const size_t rows = DIM - (i == deferred->I-1 ? deferred->pad_I : 0);
+  const size_t cols = blocks*DIM - (j + blocks == deferred->J ? deferred->pad_J : 0);
 
-          // printf("    Exit compute\n");
-        }
+  elem_t * const C_dram_addr = deferred->C + (i*deferred->C_row_len + j)*DIM;
+  const uint32_t C_sp_addr = deferred->C_sp_addr_start + deferred->block*DIM;
+
+  matmul_extended_mvout(C_dram_addr, C_sp_addr, cols, rows);
+
+  deferred->block += blocks;
+}
+
+// A residual which is added to a matmul's output inside the accumulator,
+// before the output is scaled down, instead of by a separate pass over the
+// output. Element (i, j) of R is added to output (i, j), for the first cols
+// columns of the output, after being scaled down by a rounding right shift of
+// shift bits, like vecadd's A_shift. In the accumulator, before the output is
+// scaled down by its own shift, that's R[i][j] << (output shift - shift), so
+// Gemmini applies the scale by multiplying R with a diagonal block. R is only
+// rounded once, along with the rest of the output.
+//
+// cols must be a multiple of DIM, unless it's all of the output's columns.
+struct tiled_matmul_residual_t {
+  const elem_t * R;
+  size_t row_len, cols;
+  int shift;
+};
+
+// Whether a residual's scale fits on the diagonal of an elem_t block. If it
+// doesn't, the residual is added to the output after the matmul instead.
+static int tiled_matmul_residual_fused(const struct tiled_matmul_residual_t * res,
+        int shift) {
+  return res == NULL ||
+    (res->shift <= shift && shift - res->shift < (int)(sizeof(elem_t)*8 - 1));
+}
+
+// The residual term of element (i, j) of the accumulator
+static acc_t tiled_matmul_residual_at(const struct tiled_matmul_residual_t * res,
+        int shift, size_t i, size_t j) {
+  if (res == NULL || j >= res->cols)
+    return 0;
+  return (acc_t)res->R[i*res->row_len + j] << (shift - res->shift);
+}
+
+static elem_t tiled_matmul_residual_diag[DIM][DIM] row_align(1);
+
+static void tiled_matmul_residual_build_diag(const struct tiled_matmul_residual_t * res,
+        int shift) {
+  for (size_t r = 0; r < DIM; r++)
+    for (size_t c = 0; c < DIM; c++)
+      tiled_matmul_residual_diag[r][c] = r == c ? 1 << (shift - res->shift) : 0;
+}
+
+// Adds the residual to an output tile of I x J blocks in the accumulator,
+// whose rows already hold the tile's bias, or are overwritten if overwrite is
+// set. The residual is staged where an elem_t bias would be, followed by the
+// diagonal block. Blocks of the tile past the residual's last column are
+// zeroed if they're being overwritten, and left alone otherwise. The staging
+// area is a whole scratchpad buffer, which is much larger than an output tile.
+static void sp_tiled_add_residual(const struct tiled_matmul_residual_t * res,
+        size_t res_row, size_t res_col, size_t I, size_t J,
+        size_t pad_I, size_t pad_J, uint32_t stage_sp_addr_start,
+        uint32_t acc_addr_start, int overwrite, int weight_stationary,
+        struct deferred_mvout_t * deferred) {
+  const uint32_t out_sp_addr_start = ((overwrite ? 2 : 3) << (ADDR_LEN-2)) | acc_addr_start;
+  const uint32_t diag_sp_addr = stage_sp_addr_start + I*J*DIM;
+
+  size_t res_J = res_col < res->cols ? (res->cols - res_col + DIM - 1) / DIM : 0;
+  res_J = res_J < J ? res_J : J;
+
+  if (res_J == 0 && !overwrite)
+    return;
+
+  matmul_config_ld(DIM * sizeof(elem_t));
+  matmul_mvin(tiled_matmul_residual_diag, diag_sp_addr);
+  sp_tiled_mvout_deferred(deferred);
+
+  for (size_t i = 0; i < I; i++) {
+    const size_t rows = DIM - (i == I-1 ? pad_I : 0);
+
+    for (size_t j = 0; j < J; j++) {
+      const size_t cols = DIM - (j == J-1 ? pad_J : 0);
+      const uint32_t R_sp_addr = stage_sp_addr_start + (i*J + j)*DIM;
+      const uint32_t out_sp_addr = out_sp_addr_start + (i*J + j)*DIM;
+
+      if (j >= res_J) {
+        matmul_extended_preload(GARBAGE_ADDR, out_sp_addr, DIM, DIM, cols, rows);
+        matmul_compute_preloaded(GARBAGE_ADDR, GARBAGE_ADDR);
+        continue;
+      }
+
+      if (j % MAX_BLOCK_LEN == 0) {
+        const size_t blocks = j + MAX_BLOCK_LEN <= res_J ? MAX_BLOCK_LEN : res_J - j;
+        const size_t block_cols = blocks*DIM - (j + blocks == J ? pad_J : 0);
+
+        matmul_config_ld(res->row_len * sizeof(elem_t));
+        matmul_extended_mvin(res->R + (res_row + i*DIM)*res->row_len + res_col + j*DIM,
+            R_sp_addr, block_cols, rows);
+        sp_tiled_mvout_deferred(deferred);
       }
 
-      // Move-out C
-      // if (C != NULL) {
-      //   elem_t * const C_dram_addr = C + (i*C_row_len + j)*DIM;
-      //   matmul_mvout(C_dram_addr, C_sp_addr);
-      // }
+      if (weight_stationary) {
+        matmul_extended_preload(diag_sp_addr, out_sp_addr, cols, cols, cols, rows);
+        matmul_extended_compute_preloaded(R_sp_addr, GARBAGE_ADDR, cols, rows, DIM, DIM);
+      } else {
+        matmul_extended_preload(GARBAGE_ADDR, out_sp_addr, DIM, DIM, cols, rows);
+        matmul_extended_compute_preloaded(R_sp_addr, diag_sp_addr, cols, rows, cols, cols);
+      }
     }
   }
+}
 
-  // printf("Exit main inner loop\n");
+// An implicit-GEMM convolution, whose A matrix isn't stored anywhere, but is
+// gathered from the conv's NHWC input as it's moved into the scratchpad. Row
+// p of A is output pixel p, in (batch, row, col) order, and column k is the
+// input element under kernel position (kh, kw) in input channel c, where
+// k = (kh*kernel_dim + kw)*in_channels + c. Input pixels which fall in the
+// padding read as zeros.
+//
+// in_pixel_len is the number of elements between consecutive input pixels.
+// It's in_channels, unless the conv only reads a slice of the channels of a
+// wider tensor, which is what tiled_conv_dw does.
+struct tiled_conv_t {
+  elem_t * input;
+  size_t batch_size, in_dim, in_channels, in_pixel_len, out_dim;
+  size_t stride, padding, kernel_dim;
+};
+
+// Patch rows which can't be moved in straight from the input, because they
+// overlap the padding or span two kernel rows, are gathered by the CPU into
+// this ring of staging rows first. The mvins read the staging rows
+// asynchronously, so we fence before the ring wraps around. Without extended
+// dims, the gathered rows are zero-padded to whole blocks.
+#ifndef CONV_STAGING_ROWS
+#define CONV_STAGING_ROWS 1024
+#endif
+
+static elem_t tiled_conv_staging[CONV_STAGING_ROWS][MAX_BLOCK_LEN*DIM] row_align(MAX_BLOCK_LEN);
+static size_t tiled_conv_staging_row;
+
+static void sp_tiled_conv_gather(const struct tiled_conv_t * conv,
+        size_t row, size_t col, uint32_t sp_addr, size_t cols, size_t rows) {
+  const size_t out_pixels = conv->out_dim * conv->out_dim;
+
+#ifdef HAS_EXTENDED_DIMS
+  const size_t mvin_rows = rows, mvin_cols = cols;
+#else
+  const size_t mvin_rows = DIM, mvin_cols = (cols + DIM - 1) / DIM * DIM;
+#endif
+
+  if (tiled_conv_staging_row + mvin_rows > CONV_STAGING_ROWS) {
+    matmul_fence();
+    tiled_conv_staging_row = 0;
+  }
 
-  // TODO this should be overlapped with the next "Move-in D"
-  // Move-out C
-  if (C != NULL) {
-    // printf("  Enter mvout loop\n");
+  elem_t (* const staging)[MAX_BLOCK_LEN*DIM] = &tiled_conv_staging[tiled_conv_staging_row];
+  tiled_conv_staging_row += mvin_rows;
 
-    for (size_t i = 0; i < I; i++) {
-      for (size_t j = 0; j < J; j++) {
-        // printf("    i: %lu, j: %lu\n", i, j);
+  for (size_t r = 0; r < mvin_rows; r++) {
+    const size_t p = row + r;
+    const size_t n = p / out_pixels;
+    const int oh = (p % out_pixels) / conv->out_dim;
+    const int ow = p % conv->out_dim;
 
-        elem_t * const C_dram_addr = C + (i*C_row_len + j)*DIM;
-        const uint32_t C_sp_addr = C_sp_addr_start + (i*J + j)*DIM;
+    for (size_t c = 0; c < mvin_cols; c++) {
+      const size_t k = col + c;
+      const size_t kpos = k / conv->in_channels;
+      const int ih = oh*conv->stride - conv->padding + kpos / conv->kernel_dim;
+      const int iw = ow*conv->stride - conv->padding + kpos % conv->kernel_dim;
 
-        matmul_mvout(C_dram_addr, C_sp_addr);
-      }
+      if (r >= rows || c >= cols ||
+          ih < 0 || ih >= (int)conv->in_dim || iw < 0 || iw >= (int)conv->in_dim)
+        staging[r][c] = 0;
+      else
+        staging[r][c] = conv->input[((n*conv->in_dim + ih)*conv->in_dim + iw)*conv->in_pixel_len +
+          k % conv->in_channels];
+    }
+  }
+
+  matmul_config_ld(MAX_BLOCK_LEN*DIM * sizeof(elem_t));
+  matmul_extended_mvin(staging, sp_addr, mvin_cols, mvin_rows);
+}
+
+// Moves rows x cols of the patch matrix, starting at (row, col), into the
+// scratchpad. For a given kernel row, the patch columns of an output pixel
+// are one contiguous run of the input, and consecutive output pixels in an
+// image row are conv->stride pixels apart. So each image row's worth of
+// patch rows is a single strided mvin, except for pixels whose patches
+// overlap the padding, which are gathered by the CPU. If the conv only reads
+// a slice of each pixel's channels, the run is only contiguous within one
+// kernel column. Without extended dims, a strided mvin always moves whole
+// blocks, so blocks which aren't a single run of unpadded pixels are gathered.
+static void sp_tiled_conv_mvin(const struct tiled_conv_t * conv,
+        size_t row, size_t col, uint32_t sp_addr, size_t cols, size_t rows) {
+  const size_t run_len = conv->kernel_dim * conv->in_channels;
+  const size_t out_pixels = conv->out_dim * conv->out_dim;
+
+  const size_t kh = col / run_len;
+  const size_t run_off = col % run_len;
+
+  const int kw_first = run_off / conv->in_channels;
+  const int kw_last = (run_off + cols - 1) / conv->in_channels;
+
+  if (run_off + cols > run_len ||
+      (conv->in_pixel_len != conv->in_channels && kw_first != kw_last)) {
+    sp_tiled_conv_gather(conv, row, col, sp_addr, cols, rows);
+    return;
+  }
+
+  const int pixel_stride = conv->stride;
+  const int padding = conv->padding;
+
+  for (size_t r = 0; r < rows; ) {
+    const size_t p = row + r;
+    const size_t n = p / out_pixels;
+    const int oh = (p % out_pixels) / conv->out_dim;
+    const int ow = p % conv->out_dim;
+
+    const size_t seg = rows - r < conv->out_dim - ow ? rows - r : conv->out_dim - ow;
+    const int ih = oh*pixel_stride - padding + kh;
+
+    // The output pixels in [ow_first, ow_end) of this segment only read
+    // pixels inside the image
+    int ow_first = ow, ow_end = ow + seg;
+
+    if (ih < 0 || ih >= (int)conv->in_dim) {
+      ow_end = ow_first;
+    } else {
+      while (ow_first < ow_end && ow_first*pixel_stride - padding + kw_first < 0)
+        ow_first++;
+      while (ow_end > ow_first && (ow_end-1)*pixel_stride - padding + kw_last >= (int)conv->in_dim)
+        ow_end--;
+    }
+
+#ifndef HAS_EXTENDED_DIMS
+    if (rows != DIM || cols % DIM != 0 || seg != rows ||
+        ow_first != ow || ow_end != ow + (int)seg) {
+      sp_tiled_conv_gather(conv, row, col, sp_addr, cols, rows);
+      return;
+    }
+#endif
+
+    if (ow_first > ow)
+      sp_tiled_conv_gather(conv, p, col, sp_addr + r, cols, ow_first - ow);
+
+    if (ow_end > ow_first) {
+      const int iw = ow_first*pixel_stride - padding + kw_first;
+      elem_t * const in = conv->input +
+        ((n*conv->in_dim + ih)*conv->in_dim + iw)*conv->in_pixel_len +
+        run_off % conv->in_channels;
+
+      matmul_config_ld(pixel_stride * conv->in_pixel_len * sizeof(elem_t));
+      matmul_extended_mvin(in, sp_addr + r + (ow_first - ow), cols, ow_end - ow_first);
     }
 
-    // printf("  Exit mvout loop\n");
+    if (ow + seg > ow_end)
+      sp_tiled_conv_gather(conv, row + r + (ow_end - ow), col,
+          sp_addr + r + (ow_end - ow), cols, ow + seg - ow_end);
+
+    r += seg;
   }
 }
 
+// Moves rows x cols of A, starting at block (i, k) of the current A tile, into
+// the scratchpad. The tile either starts at A, or at (conv_row, conv_col) of
+// conv's patch matrix.
+static void sp_tiled_mvin_A(elem_t * A, size_t A_row_len,
+        const struct tiled_conv_t * conv, size_t conv_row, size_t conv_col,
+        size_t i, size_t k, uint32_t A_sp_addr, size_t cols, size_t rows) {
+  if (conv != NULL) {
+    sp_tiled_conv_mvin(conv, conv_row + i*DIM, conv_col + k*DIM, A_sp_addr, cols, rows);
+  } else {
+    matmul_config_ld(A_row_len * sizeof(elem_t));
+    matmul_extended_mvin(A + (i*A_row_len + k)*DIM, A_sp_addr, cols, rows);
+  }
+}
 
-// static void sp_tiled_matmul_ws(elem_t * A, elem_t * B, acc_t * D, elem_t * C,
-static void sp_tiled_matmul_ws(elem_t * A, elem_t * B, void * D, elem_t * C,
-        size_t I, size_t J, size_t K, size_t A_row_len,
-        size_t B_row_len, size_t D_row_len, size_t C_row_len,
-        int first_mvin, int last_mvout, int no_bias, int full_bias_width) {
+// The A and B move-ins of the next sp_tiled call, which are issued early,
+// between the computes of the current call. Otherwise the next call's loads
+// would sit behind all of this call's computes, and the load queue would go
+// idle while the core stalls on the full execute queue. The tiles are moved
+// in exactly as the next call would have moved them in itself. mvins is the
+// total number of move-ins, A_mvins of which are for A, and mvin is the next
+// one to issue.
+struct prefetch_mvin_t {
+  elem_t * A, * B;
+  const struct tiled_conv_t * conv;
+  size_t conv_row, conv_col;
+  uint32_t A_sp_addr_start, B_sp_addr_start;
+  size_t I, J, K, pad_I, pad_J, pad_K;
+  size_t A_row_len, B_row_len;
+  size_t A_mvins, mvins, mvin;
+};
+
+static void sp_tiled_prefetch_init(struct prefetch_mvin_t * next,
+        elem_t * A, elem_t * B, const struct tiled_conv_t * conv,
+        size_t conv_row, size_t conv_col, size_t I, size_t J, size_t K,
+        size_t pad_I, size_t pad_J, size_t pad_K,
+        size_t A_row_len, size_t B_row_len,
+        uint32_t A_sp_addr_start, uint32_t B_sp_addr_start,
+        int mvin_A, int mvin_B) {
+  const size_t A_blocks = K <= MAX_BLOCK_LEN ? K : MAX_BLOCK_LEN;
+  const size_t B_blocks = J <= MAX_BLOCK_LEN ? J : MAX_BLOCK_LEN;
+
+  *next = (struct prefetch_mvin_t) {
+    .A = A, .B = B, .conv = conv, .conv_row = conv_row, .conv_col = conv_col,
+    .A_sp_addr_start = A_sp_addr_start, .B_sp_addr_start = B_sp_addr_start,
+    .I = I, .J = J, .K = K, .pad_I = pad_I, .pad_J = pad_J, .pad_K = pad_K,
+    .A_row_len = A_row_len, .B_row_len = B_row_len,
+    .A_mvins = mvin_A ? I * ((K + A_blocks - 1) / A_blocks) : 0,
+    .mvin = 0,
+  };
+
+  next->mvins = next->A_mvins + (mvin_B ? K * ((J + B_blocks - 1) / B_blocks) : 0);
+}
 
-  const uint32_t A_sp_addr_start = 0;
-  const uint32_t B_sp_addr_start = BANK_NUM * BANK_ROWS / 2;
-  const uint32_t D_sp_addr_start = 1 << (ADDR_LEN-1);
-  const uint32_t C_sp_addr_start = 3 << (ADDR_LEN-2);
+// Issues the next call's move-ins at an even rate, so that they've all been
+// issued by the time the current call's last compute is
+static void sp_tiled_prefetch(struct prefetch_mvin_t * next,
+        size_t computes_done, size_t computes) {
+  if (next == NULL)
+    return;
+
+  while (next->mvin < next->mvins && next->mvin * computes < computes_done * next->mvins) {
+    const size_t n = next->mvin++;
+
+    if (n < next->A_mvins) {
+      const size_t A_blocks = next->K <= MAX_BLOCK_LEN ? next->K : MAX_BLOCK_LEN;
+      const size_t K_mvins = (next->K + A_blocks - 1) / A_blocks;
+      const size_t i = n / K_mvins;
+      const size_t k = (n % K_mvins) * A_blocks;
+
+      const size_t blocks = k + A_blocks <= next->K ? A_blocks : next->K - k;
+      const size_t rows = DIM - (i == next->I-1 ? next->pad_I : 0);
+      const size_t cols = blocks*DIM - (k + blocks == next->K ? next->pad_K : 0);
+
+      sp_tiled_mvin_A(next->A, next->A_row_len, next->conv, next->conv_row,
+          next->conv_col, i, k, next->A_sp_addr_start + (i*next->K + k)*DIM,
+          cols, rows);
+    } else {
+      const size_t B_blocks = next->J <= MAX_BLOCK_LEN ? next->J : MAX_BLOCK_LEN;
+      const size_t J_mvins = (next->J + B_blocks - 1) / B_blocks;
+      const size_t k = (n - next->A_mvins) / J_mvins;
+      const size_t j = ((n - next->A_mvins) % J_mvins) * B_blocks;
+
+      const size_t blocks = j + B_blocks <= next->J ? B_blocks : next->J - j;
+      const size_t rows = DIM - (k == next->K-1 ? next->pad_K : 0);
+      const size_t cols = blocks*DIM - (j + blocks == next->J ? next->pad_J : 0);
+
+      matmul_config_ld(next->B_row_len * sizeof(elem_t));
+      matmul_extended_mvin(next->B + (k*next->B_row_len + j)*DIM,
+          next->B_sp_addr_start + (k*next->J + j)*DIM, cols, rows);
+    }
+  }
+}
 
-  const int A_blocks = K <= MAX_BLOCK_LEN ? K : MAX_BLOCK_LEN;
-  const int B_blocks = J <= MAX_BLOCK_LEN ? J : MAX_BLOCK_LEN;
-  const int D_blocks_max = full_bias_width ? MAX_BLOCK_LEN_ACC : MAX_BLOCK_LEN;
-  const int D_blocks = J <= D_blocks_max ? J : D_blocks_max;
+// The arguments of one sp_tiled_matmul call, which computes an output tile of
+// I x J blocks from I x K blocks of A and K x J blocks of B. The last row or
+// column of blocks along each dimension is missing pad_I, pad_J or pad_K rows
+// or columns. A and B are only moved in if mvin_A and mvin_B are set, as they
+// may still be in the scratchpad from an earlier call. If conv isn't NULL, A is
+// the tile at (conv_row, conv_col) of its patch matrix. A bias which isn't
+// full width, or a residual from (res_row, res_col), is staged at
+// bias_sp_addr_start. Unless last_mvout is set, C is left in the accumulator
+// for the next call to move out.
+struct sp_tiled_matmul_t {
+  elem_t * A, * B;
+  void * D;
+  elem_t * C;
+  size_t I, J, K, pad_I, pad_J, pad_K;
+  size_t A_row_len, B_row_len, D_row_len, C_row_len;
+  uint32_t A_sp_addr_start, B_sp_addr_start, bias_sp_addr_start, acc_addr_start;
+  int mvin_A, mvin_B;
+  const struct tiled_conv_t * conv;
+  size_t conv_row, conv_col;
+  const struct tiled_matmul_residual_t * res;
+  size_t res_row, res_col;
+  int first_mvin, last_mvout, no_bias, full_bias_width;
+};
+
+// Moves the tile's bias into the accumulator. A bias which isn't full width is
+// moved into the scratchpad, and widened by passing it through the array: OS
+// preloads it as the array's partial sums, while WS adds it to an empty
+// product as the compute's D operand.
+static void sp_tiled_mvin_bias(const struct sp_tiled_matmul_t * tile,
+        int dataflow, struct deferred_mvout_t * deferred) {
+  const size_t I = tile->I, J = tile->J;
+  const uint32_t D_sp_addr_start = (1 << (ADDR_LEN-1)) | tile->acc_addr_start;
+
+  const size_t D_blocks_max = tile->full_bias_width ? MAX_BLOCK_LEN_ACC : MAX_BLOCK_LEN;
+  const size_t D_blocks = J <= D_blocks_max ? J : D_blocks_max;
+  const size_t sizeof_bias = tile->full_bias_width ? sizeof(acc_t) : sizeof(elem_t);
+
+  matmul_config_ld(tile->D_row_len * sizeof_bias);
 
-  const int sizeof_bias = full_bias_width ? sizeof(acc_t) : sizeof(elem_t);
+  for (size_t i = 0; i < I; i++) {
+    const size_t rows = DIM - (i == I-1 ? tile->pad_I : 0);
 
-  const int I_iterations = I;
-  const int J_iterations = (J/B_blocks + (J % B_blocks != 0));
-  const int K_iterations = (K/A_blocks + (K % A_blocks != 0));
-  const int total_iterations = I_iterations * J_iterations * K_iterations;
+    for (size_t j = 0; j < J; j++) {
+      const size_t cols = DIM - (j == J-1 ? tile->pad_J : 0);
 
-  int old_iterations = total_iterations;
+      const uint32_t D_sp_addr_acc = D_sp_addr_start + (i*J + j)*DIM;
+      const uint32_t D_sp_addr_sp = tile->bias_sp_addr_start + (i*J + j)*DIM;
 
-  // Move-in D
-  if (D != NULL && !no_bias) {
-    matmul_config_ld(D_row_len * sizeof_bias);
+      if (j % D_blocks == 0) {
+        const size_t blocks = j + D_blocks <= J ? D_blocks : J-j;
+        const size_t block_cols = blocks*DIM - (j + blocks == J ? tile->pad_J : 0);
+        const size_t offset = (i*tile->D_row_len + j)*DIM;
 
-    for (size_t i = 0; i < I; i++) {
-      for (size_t j = 0; j < J; j++) {
-        void * D_dram_addr;
-        uint32_t D_sp_addr_acc = D_sp_addr_start + (i*J + j)*DIM;
-        uint32_t D_sp_addr_sp = (i*J + j)*DIM;
-
-        if (full_bias_width) {
-          acc_t * const D_ = (acc_t *) D;
-          D_dram_addr = (void*)(D_ + (i*D_row_len + j)*DIM);
+        if (tile->full_bias_width) {
+          matmul_extended_mvin((acc_t *)tile->D + offset, D_sp_addr_acc, block_cols, rows);
         } else {
-          elem_t * const D_ = (elem_t *) D;
-          D_dram_addr = (void*)(D_ + (i*D_row_len + j)*DIM);
+          matmul_extended_mvin((elem_t *)tile->D + offset, D_sp_addr_sp, block_cols, rows);
         }
 
-        int already_moved_in = j % D_blocks != 0;
+        sp_tiled_mvout_deferred(deferred);
+      }
+
+      if (tile->full_bias_width) {
+        continue;
+      } else if (dataflow == OUTPUT_STATIONARY) {
+        matmul_extended_preload(D_sp_addr_sp, D_sp_addr_acc, cols, rows, cols, rows);
+        matmul_compute_preloaded(GARBAGE_ADDR, GARBAGE_ADDR);
+      } else {
+        matmul_extended_preload(GARBAGE_ADDR, D_sp_addr_acc, DIM, DIM, cols, rows);
+        matmul_extended_compute_preloaded(GARBAGE_ADDR, D_sp_addr_sp, DIM, DIM, cols, rows);
+      }
+    }
+  }
+}
+
+// Moves in the blocks of A and B which the compute on blocks (i, j, k) is the
+// first to use. Up to MAX_BLOCK_LEN blocks of a row of A are moved in when j
+// is 0, and up to MAX_BLOCK_LEN blocks of a row of B when i is 0.
+static void sp_tiled_mvin_AB(const struct sp_tiled_matmul_t * tile,
+        size_t i, size_t j, size_t k, struct deferred_mvout_t * deferred) {
+  const size_t A_blocks = tile->K <= MAX_BLOCK_LEN ? tile->K : MAX_BLOCK_LEN;
+  const size_t B_blocks = tile->J <= MAX_BLOCK_LEN ? tile->J : MAX_BLOCK_LEN;
+
+  if (tile->mvin_A && j == 0 && k % A_blocks == 0) {
+    const size_t blocks = k + A_blocks <= tile->K ? A_blocks : tile->K - k;
+    const size_t rows = DIM - (i == tile->I-1 ? tile->pad_I : 0);
+    const size_t cols = blocks*DIM - (k + blocks == tile->K ? tile->pad_K : 0);
+
+    sp_tiled_mvin_A(tile->A, tile->A_row_len, tile->conv, tile->conv_row, tile->conv_col,
+        i, k, tile->A_sp_addr_start + (i*tile->K + k)*DIM, cols, rows);
+    sp_tiled_mvout_deferred(deferred);
+  }
 
-        if (!already_moved_in) {
-          int blocks = j + D_blocks <= J ? D_blocks : J-j;
+  if (tile->mvin_B && i == 0 && j % B_blocks == 0) {
+    const size_t blocks = j + B_blocks <= tile->J ? B_blocks : tile->J - j;
+    const size_t rows = DIM - (k == tile->K-1 ? tile->pad_K : 0);
+    const size_t cols = blocks*DIM - (j + blocks == tile->J ? tile->pad_J : 0);
 
-          if (full_bias_width) {
-            matmul_block_mvin(D_dram_addr, D_sp_addr_acc, blocks);
-          } else /*if (!full_bias_width)*/ {
-            matmul_block_mvin(D_dram_addr, D_sp_addr_sp, blocks);
-          }
+    matmul_config_ld(tile->B_row_len * sizeof(elem_t));
+    matmul_extended_mvin(tile->B + (k*tile->B_row_len + j)*DIM,
+        tile->B_sp_addr_start + (k*tile->J + j)*DIM, cols, rows);
+    sp_tiled_mvout_deferred(deferred);
+  }
+}
+
+// Output-stationary: every output block stays in the array while it
+// accumulates over k, and is only written to the accumulator after the last k
+static void sp_tiled_matmul_os(const struct sp_tiled_matmul_t * tile,
+        struct deferred_mvout_t * deferred, struct prefetch_mvin_t * next) {
+  const size_t I = tile->I, J = tile->J, K = tile->K;
+  const uint32_t C_sp_addr_start = (3 << (ADDR_LEN-2)) | tile->acc_addr_start;
+
+  for (size_t i = 0; i < I; i++) {
+    const size_t I_rows = DIM - (i == I-1 ? tile->pad_I : 0);
+
+    for (size_t j = 0; j < J; j++) {
+      const size_t J_cols = DIM - (j == J-1 ? tile->pad_J : 0);
+      const uint32_t C_sp_addr = C_sp_addr_start + (i*J + j)*DIM;
+
+      for (size_t k = 0; k < K; k++) {
+        const size_t K_len = DIM - (k == K-1 ? tile->pad_K : 0);
+
+        const uint32_t A_sp_addr = tile->A_sp_addr_start + (i*K + k)*DIM;
+        const uint32_t B_sp_addr = tile->B_sp_addr_start + (k*J + j)*DIM;
+
+        sp_tiled_mvin_AB(tile, i, j, k, deferred);
+
+        uint32_t out_sp_addr = k == K-1 ? C_sp_addr : GARBAGE_ADDR;
+
+        // If we're not using a bias or a residual, then we want to overwrite
+        // what's in the accumulator, rather than writing over it
+        if (tile->no_bias && tile->D != NULL && tile->res == NULL && k == K-1) {
+          out_sp_addr &= ~(1 << (ADDR_LEN-2));
         }
 
-        if (!full_bias_width) {
-          matmul_preload(GARBAGE_ADDR, D_sp_addr_acc);
-          matmul_compute_preloaded(GARBAGE_ADDR, D_sp_addr_sp);
+        matmul_extended_preload(GARBAGE_ADDR, out_sp_addr, DIM, DIM, J_cols, I_rows);
+
+        if (k == 0) { // First iteration
+          matmul_extended_compute_preloaded(A_sp_addr, B_sp_addr, K_len, I_rows, J_cols, K_len);
+        } else { // All other iterations
+          matmul_extended_compute_accumulated(A_sp_addr, B_sp_addr, K_len, I_rows, J_cols, K_len);
         }
+
+        sp_tiled_prefetch(next, (i*J + j)*K + k + 1, I*J*K);
       }
     }
   }
+}
+
+// Weight-stationary: every block of B is preloaded into the array once, and
+// stays there while the column of A blocks it multiplies streams through
+static void sp_tiled_matmul_ws(const struct sp_tiled_matmul_t * tile,
+        struct deferred_mvout_t * deferred, struct prefetch_mvin_t * next) {
+  const size_t I = tile->I, J = tile->J, K = tile->K;
+  const uint32_t C_sp_addr_start = (3 << (ADDR_LEN-2)) | tile->acc_addr_start;
 
   for (size_t j = 0; j < J; j++) {
+    const size_t J_cols = DIM - (j == J-1 ? tile->pad_J : 0);
+
     for (size_t k = 0; k < K; k++) {
-      const uint32_t B_sp_addr = B_sp_addr_start + (k*J + j)*DIM;
+      const size_t K_len = DIM - (k == K-1 ? tile->pad_K : 0);
+      const uint32_t B_sp_addr = tile->B_sp_addr_start + (k*J + j)*DIM;
 
       for (size_t i = 0; i < I; i++) {
-        elem_t * const A_dram_addr = A + (i*A_row_len + k)*DIM;
-        elem_t * const B_dram_addr = B + (k*B_row_len + j)*DIM;
+        const size_t I_rows = DIM - (i == I-1 ? tile->pad_I : 0);
 
-        const uint32_t A_sp_addr = A_sp_addr_start + (i*K + k)*DIM;
+        const uint32_t A_sp_addr = tile->A_sp_addr_start + (i*K + k)*DIM;
         const uint32_t C_sp_addr = C_sp_addr_start + (i*J + j)*DIM;
 
-        // Move-in A and B
-        {
-          int A_already_moved_in = j != 0 || k % A_blocks != 0;
-          int B_already_moved_in = i != 0 || j % B_blocks != 0;
+        sp_tiled_mvin_AB(tile, i, j, k, deferred);
 
-          if (!A_already_moved_in) {
-            matmul_config_ld(A_row_len * sizeof(elem_t));
+        const uint32_t pre_sp_addr = i == 0 ? B_sp_addr : GARBAGE_ADDR;
+        uint32_t out_sp_addr = C_sp_addr;
 
-            int blocks = k + A_blocks <= K ? A_blocks : K-k;
-            // printf("Moving in %d blocks of A: %u\n", blocks, A_sp_addr);
-            matmul_block_mvin(A_dram_addr, A_sp_addr, blocks);
-          }
+        // If we're not using a bias or a residual, then we want to overwrite
+        // what's in the accumulator, rather than writing over it
+        if (tile->no_bias && tile->D != NULL && tile->res == NULL && k == 0) {
+          out_sp_addr &= ~(1 << (ADDR_LEN-2));
+        }
 
-          if (!B_already_moved_in) {
-            matmul_config_ld(B_row_len * sizeof(elem_t));
+        matmul_extended_preload(pre_sp_addr, out_sp_addr, J_cols, K_len, J_cols, I_rows);
 
-            int blocks = j + B_blocks <= J ? B_blocks : J-j;
-            // printf("Moving in %d blocks of B: %u\n", blocks, B_sp_addr);
-            matmul_block_mvin(B_dram_addr, B_sp_addr, blocks);
-          }
+        if (i == 0) { // First iteration
+          matmul_extended_compute_preloaded(A_sp_addr, GARBAGE_ADDR, K_len, I_rows, DIM, DIM);
+        } else { // All other iterations
+          matmul_extended_compute_accumulated(A_sp_addr, GARBAGE_ADDR, K_len, I_rows, DIM, DIM);
         }
 
-        // Compute
-        {
-          uint32_t pre_sp_addr = i == 0 ? B_sp_addr : GARBAGE_ADDR;
-          uint32_t out_sp_addr = C_sp_addr;
+        sp_tiled_prefetch(next, (j*K + k)*I + i + 1, I*J*K);
+      }
+    }
+  }
+}
 
-          // If we're not using a bias, then we want to overwrite what's in the
-          // accumulator, rather than writing over it
-          int no_bias_new_matrix = no_bias && D != NULL && k == 0;
-          if (no_bias_new_matrix) {
-            out_sp_addr &= ~(1 << (ADDR_LEN-2));
-          }
+// Computes one output tile with the given dataflow, which Gemmini has to have
+// been configured for. prev is the previous call's output tile, if its
+// move-out was deferred to this call, and next is the next call's move-ins,
+// if they're issued early.
+static void sp_tiled_matmul(const struct sp_tiled_matmul_t * tile, int dataflow,
+        struct deferred_mvout_t * prev, struct prefetch_mvin_t * next) {
+  const size_t I = tile->I, J = tile->J;
+  const uint32_t C_sp_addr_start = (3 << (ADDR_LEN-2)) | tile->acc_addr_start;
 
-          int final_submatrix = i == I-1 && j == J-1 && k == K-1 && C != NULL;
+  struct deferred_mvout_t * const deferred = tile->first_mvin ? NULL : prev;
 
-          matmul_preload(pre_sp_addr, out_sp_addr);
+  // Move-in D
+  if (tile->D != NULL && !tile->no_bias) {
+    sp_tiled_mvin_bias(tile, dataflow, deferred);
+  }
 
-          if (i == 0) { // First iteration
-            matmul_compute_preloaded(A_sp_addr, GARBAGE_ADDR);
-          } else { // All other iterations
-            matmul_compute_accumulated(A_sp_addr, GARBAGE_ADDR);
-          }
-        }
-      }
-    }
+  // Add the residual on top of the bias
+  if (tile->D != NULL && tile->res != NULL) {
+    sp_tiled_add_residual(tile->res, tile->res_row, tile->res_col, I, J,
+        tile->pad_I, tile->pad_J, tile->bias_sp_addr_start, tile->acc_addr_start,
+        tile->no_bias, dataflow == WEIGHT_STATIONARY, deferred);
   }
 
-  // TODO this should be overlapped with the next "Move-in D"
-  // Move-out C
-  if (C != NULL) {
+  if (dataflow == OUTPUT_STATIONARY) {
+    sp_tiled_matmul_os(tile, deferred, next);
+  } else {
+    sp_tiled_matmul_ws(tile, deferred, next);
+  }
+
+  // Move-out whatever is left of the previous output tile
+  while (deferred != NULL && deferred->C != NULL &&
+      deferred->block < deferred->I * deferred->J) {
+    sp_tiled_mvout_deferred(deferred);
+  }
+
+  // Move-out C, unless the caller has deferred it to the next call
+  if (tile->C != NULL && tile->last_mvout) {
     for (size_t i = 0; i < I; i++) {
-      for (size_t j = 0; j < J; j++) {
-        elem_t * const C_dram_addr = C + (i*C_row_len + j)*DIM;
-        const uint32_t C_sp_addr = C_sp_addr_start + (i*J + j)*DIM;
+      const size_t rows = DIM - (i == I-1 ? tile->pad_I : 0);
 
-        matmul_mvout(C_dram_addr, C_sp_addr);
+      for (size_t j = 0; j < J; j += MAX_BLOCK_LEN_ST) {
+        const size_t blocks = j + MAX_BLOCK_LEN_ST <= J ? MAX_BLOCK_LEN_ST : J-j;
+        const size_t cols = blocks*DIM - (j + blocks == J ? tile->pad_J : 0);
+
+        matmul_extended_mvout(tile->C + (i*tile->C_row_len + j)*DIM,
+            C_sp_addr_start + (i*J + j)*DIM, cols, rows);
       }
     }
   }
 }
 
-static void tiled_matmul_os(size_t DIM_I, size_t DIM_J, size_t DIM_K,
-        // elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
-        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void* D,
-        elem_t C[DIM_I][DIM_J], size_t TILE_I, size_t TILE_J, size_t TILE_K,
-        int act, int shift, int relu6_shift, int full_bias_width) {
-
-    const int I0 = DIM_I / (TILE_I*DIM);
-    const int J0 = DIM_J / (TILE_J*DIM);
-    const int K0 = DIM_K / (TILE_K*DIM);
-
-    const int no_bias = D == NULL;
-
-    if (no_bias) {
-      // D = (acc_t (*)[DIM_J]) 1; // Dummy address which isn't NULL
-      D = (void*) 1; // Dummy address which isn't NULL
+// Gemmini can only move out rows of C, but the next layer may want its input
+// channel-major, as a [DIM_I/C_pixels][DIM_J][C_pixels] NCHW tensor. Such an
+// output is moved out one output tile at a time into one of two staging
+// buffers, and transposed into place by the CPU while the tile is still in
+// the cache. A staging buffer is only reused once its previous tile has been
+// transposed, which takes a fence, so there's one fence per output tile
+// rather than a separate col2im pass over the whole output.
+struct tiled_matmul_staged_out_t {
+  size_t row, col, rows, cols;
+  int pending;
+};
+
+static elem_t tiled_matmul_out_staging[2][ACC_ROWS*DIM] row_align(1);
+
+static void tiled_matmul_unstage_out(elem_t * C, size_t DIM_J, size_t C_pixels,
+        size_t row_len, const elem_t * staging,
+        struct tiled_matmul_staged_out_t * staged) {
+  if (!staged->pending)
+    return;
+
+  for (size_t c = 0; c < staged->cols; c++) {
+    const size_t j = staged->col + c;
+    size_t n = staged->row / C_pixels;
+    size_t pixel = staged->row % C_pixels;
+    elem_t * dst = C + (n*DIM_J + j)*C_pixels + pixel;
+
+    for (size_t r = 0; r < staged->rows; r++) {
+      *dst++ = staging[r*row_len + c];
+
+      if (++pixel == C_pixels) {
+        pixel = 0;
+        n++;
+        dst = C + (n*DIM_J + j)*C_pixels;
+      }
     }
+  }
 
-    matmul_config_ex(OUTPUT_STATIONARY, act, 0, shift, relu6_shift);
-    matmul_config_st(DIM_J * sizeof(elem_t));
-
-    for (size_t i0 = 0; i0 < I0; i0++)
-      for (size_t j0 = 0; j0 < J0; j0++)
-        for (size_t k0 = 0; k0 < K0; k0++) {
-          // printf("i0: %lu, j0: %lu, k0: %lu\n", i0, j0, k0);
-
-          int first_mvin = i0 == 0 && j0 == 0 && k0 == 0;
-          int last_mvout = (i0 == I0-1) && (j0 == J0-1) && (k0 == K0-1);
+  staged->pending = 0;
+}
 
-          // acc_t * pre = k0 == 0 ? &D[i0*TILE_I*DIM][j0*TILE_J*DIM] : NULL;
-          void * pre;
-          if (k0 != 0) {
-            pre = NULL;
-          } else if (full_bias_width) {
-            pre = &((acc_t (*)[DIM_J])D)[i0*TILE_I*DIM][j0*TILE_J*DIM];
-          } else {
-            pre = &((elem_t (*)[DIM_J])D)[i0*TILE_I*DIM][j0*TILE_J*DIM];
-          }
+// Returns the staging buffer that the output tile at (row, col) should be
+// moved out to, after transposing whichever tile was left in it
+static elem_t * tiled_matmul_stage_out(elem_t * C, size_t DIM_J, size_t C_pixels,
+        size_t row_len, struct tiled_matmul_staged_out_t staged[2], int * slot,
+        size_t row, size_t col, size_t rows, size_t cols) {
+  elem_t * const staging = tiled_matmul_out_staging[*slot];
 
-          elem_t * out = k0 == K0-1 ? &C[i0*TILE_I*DIM][j0*TILE_J*DIM] : NULL;
+  if (staged[*slot].pending) {
+    matmul_fence();
+    tiled_matmul_unstage_out(C, DIM_J, C_pixels, row_len, staging, &staged[*slot]);
+  }
 
-          sp_tiled_matmul_os(&A[i0*TILE_I*DIM][k0*TILE_K*DIM],
-              &B[k0*TILE_K*DIM][j0*TILE_J*DIM],
-              pre, out,
-              TILE_I, TILE_J, TILE_K,
-              DIM_K, DIM_J, DIM_J, DIM_J,
-              first_mvin, last_mvout, no_bias, full_bias_width);
-        }
+  staged[*slot] = (struct tiled_matmul_staged_out_t) {
+    .row = row, .col = col, .rows = rows, .cols = cols, .pending = 1,
+  };
+  *slot = !*slot;
 
-    matmul_fence();
+  return staging;
 }
 
-static void tiled_matmul_ws(size_t DIM_I, size_t DIM_J, size_t DIM_K,
-        // elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
+// DIM_I, DIM_J and DIM_K don't have to be multiples of DIM, or of the tile
+// sizes. The final tile along each dimension is simply smaller, and its last
+// row or column of blocks is only partially moved in, computed and moved out.
+// The tiles are visited in the given loop order. If C_pixels isn't 0, C is
+// written channel-major, as described above.
+static void tiled_matmul_conv(size_t DIM_I, size_t DIM_J, size_t DIM_K,
         elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
         elem_t C[DIM_I][DIM_J], size_t TILE_I, size_t TILE_J, size_t TILE_K,
+        enum tiled_matmul_loop_order_t loop_order, int dataflow,
+        const struct tiled_conv_t * conv, size_t C_pixels,
+        const struct tiled_matmul_residual_t * res,
         int act, int shift, int relu6_shift, int full_bias_width) {
 
-    const int I0 = DIM_I / (TILE_I*DIM);
-    const int J0 = DIM_J / (TILE_J*DIM);
-    const int K0 = DIM_K / (TILE_K*DIM);
+    const size_t I_blocks = (DIM_I + DIM - 1) / DIM;
+    const size_t J_blocks = (DIM_J + DIM - 1) / DIM;
+    const size_t K_blocks = (DIM_K + DIM - 1) / DIM;
+
+    const size_t I0 = (I_blocks + TILE_I - 1) / TILE_I;
+    const size_t J0 = (J_blocks + TILE_J - 1) / TILE_J;
+    const size_t K0 = (K_blocks + TILE_K - 1) / TILE_K;
+
+    const size_t last_I = I_blocks - (I0-1)*TILE_I;
+    const size_t last_J = J_blocks - (J0-1)*TILE_J;
+    const size_t last_K = K_blocks - (K0-1)*TILE_K;
+
+    const size_t pad_I = I_blocks*DIM - DIM_I;
+    const size_t pad_J = J_blocks*DIM - DIM_J;
+    const size_t pad_K = K_blocks*DIM - DIM_K;
 
     const int no_bias = D == NULL;
 
     if (no_bias) {
-      // D = (acc_t (*)[DIM_J]) 1; // Dummy address which isn't NULL
       D = (void*) 1; // Dummy address which isn't NULL
     }
 
-    matmul_config_ex(WEIGHT_STATIONARY, act, 0, shift, relu6_shift);
-    matmul_config_st(DIM_J * sizeof(elem_t));
+    if (res != NULL) {
+      tiled_matmul_residual_build_diag(res, shift);
+    }
+
+    // If both tiles fit in half of their partitions, we alternate between the
+    // two halves whenever a new tile is moved in, so consecutive tiles never
+    // share spad rows
+    const int double_buffered = sp_tiles_fit_double_buffered(TILE_I, TILE_J, TILE_K);
+    int A_buf = 0, B_buf = 0;
+    size_t A_i0 = 0, A_k0 = 0, B_k0 = 0, B_j0 = 0;
+
+    // Whether the current call's A and B tiles were already moved in by the
+    // previous call
+    int A_prefetched = 0, B_prefetched = 0;
+    struct prefetch_mvin_t next_in;
+
+    // All the output tiles that the loop order keeps resident have to fit in
+    // the accumulator. If they don't, we fall back to finishing one output
+    // tile at a time.
+    const size_t acc_tile_rows = TILE_I*TILE_J*DIM;
+    size_t resident = tiled_matmul_loop_resident_tiles(loop_order, I0, J0, K0);
+
+    if (resident * acc_tile_rows > ACC_ROWS) {
+      loop_order = LOOP_IJK;
+      resident = 1;
+    }
 
-    for (size_t i0 = 0; i0 < I0; i0++)
-      for (size_t j0 = 0; j0 < J0; j0++)
-        for (size_t k0 = 0; k0 < K0; k0++) {
-          /*
-          if (i0 == 0 && j0 == 0) {
-            printf("Outer: i0: %u, j0: %u, k0: %u\n", i0, j0, k0);
-          }
-          */
+    // Similarly, if the resident output tiles fit in half the accumulator, the
+    // next set of tiles goes in the other half. Then an output tile's move-out
+    // can be deferred to the next call, where it's interleaved with that
+    // call's D, A and B move-ins.
+    const int acc_double_buffered = resident * acc_tile_rows <= ACC_BUFFER_ROWS;
+    struct deferred_mvout_t prev_out = { .C = NULL };
 
-          int first_mvin = i0 == 0 && j0 == 0 && k0 == 0;
-          int last_mvout = (i0 == I0-1) && (j0 == J0-1) && (k0 == K0-1);
+    // Channel-major output tiles are moved out to a staging buffer, whose
+    // rows are a whole tile wide
+    struct tiled_matmul_staged_out_t staged[2] = {{ .pending = 0 }, { .pending = 0 }};
+    int stage_slot = 0;
+    const size_t C_row_len = C_pixels != 0 ? TILE_J*DIM : DIM_J;
 
-          // acc_t * pre = k0 == 0 ? &D[i0*TILE_I*DIM][j0*TILE_J*DIM] : NULL;
-          void * pre;
-          if (k0 != 0) {
-            pre = NULL;
-          } else if (full_bias_width) {
-            pre = &((acc_t (*)[DIM_J])D)[i0*TILE_I*DIM][j0*TILE_J*DIM];
-          } else {
-            pre = &((elem_t (*)[DIM_J])D)[i0*TILE_I*DIM][j0*TILE_J*DIM];
-          }
+    tiled_matmul_counters = (struct tiled_matmul_counters_t) {
+      .A_size = DIM_I*DIM_K, .B_size = DIM_K*DIM_J, .C_size = DIM_I*DIM_J,
+    };
 
-          elem_t * out = k0 == K0-1 ? &C[i0*TILE_I*DIM][j0*TILE_J*DIM] : NULL;
+    matmul_config_ex(dataflow, act, 0, shift, relu6_shift);
+    matmul_config_st(C_row_len * sizeof(elem_t));
 
-          /*
-          if (i0 == 0 && j0 == 0) {
-            printf("  pre is %p\n", pre);
-            if (pre != NULL) {
-              printf("    bias is %d\n", ((acc_t (*)[DIM_J])pre)[0][1]);
-            }
+    const size_t calls = I0*J0*K0;
 
-            printf("  out is %p\n", out);
-          }
-          */
-
-          sp_tiled_matmul_ws(&A[i0*TILE_I*DIM][k0*TILE_K*DIM],
-              &B[k0*TILE_K*DIM][j0*TILE_J*DIM],
-              pre, out,
-              TILE_I, TILE_J, TILE_K,
-              DIM_K, DIM_J, DIM_J, DIM_J,
-              first_mvin, last_mvout, no_bias, full_bias_width);
-
-          /*
-          if (i0 == 0 && j0 == 0) {
-            if (out != NULL) {
-              printf("    result is %d\n", ((elem_t (*)[DIM_J])out)[0][1]);
-              printf("    actual result is %d\n", C[0][1]);
-            }
-          }
-          */
-        }
+    for (size_t t = 0; t < calls; t++) {
+      size_t i0, j0, k0, slot, group;
+      tiled_matmul_loop_index(loop_order, t, I0, J0, K0, &i0, &j0, &k0, &slot, &group);
 
-    matmul_fence();
+      const uint32_t acc_addr = tiled_matmul_acc_addr(slot, group, acc_tile_rows,
+          acc_double_buffered);
 
-    // printf("    final result is %d\n", C[0][1]);
-}
+      int first_mvin = t == 0;
+      int last_mvout = t == calls-1;
 
-static void matmul_cpu(size_t DIM_I, size_t DIM_J, size_t DIM_K,
-        // elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
-        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
-        elem_t C[DIM_I][DIM_J],
-        int act, int shift, int relu6_shift, int full_bias_width) {
+      const size_t I = i0 < I0-1 ? TILE_I : last_I;
+      const size_t J = j0 < J0-1 ? TILE_J : last_J;
+      const size_t K = k0 < K0-1 ? TILE_K : last_K;
 
-  const int no_bias = D == NULL;
+      const size_t pad_I_ = i0 == I0-1 ? pad_I : 0;
+      const size_t pad_J_ = j0 == J0-1 ? pad_J : 0;
+      const size_t pad_K_ = k0 == K0-1 ? pad_K : 0;
 
-  for (size_t i = 0; i < DIM_I; i++) {
-    for (size_t j = 0; j < DIM_J; j++) {
-      acc_t result;
-      if (full_bias_width) {
-        result = no_bias ? 0 : ((acc_t (*)[DIM_J])D)[i][j];
+      void * pre;
+      if (k0 != 0) {
+        pre = NULL;
+      } else if (full_bias_width) {
+        pre = &((acc_t (*)[DIM_J])D)[i0*TILE_I*DIM][j0*TILE_J*DIM];
       } else {
-        result = no_bias ? 0 : ((elem_t (*)[DIM_J])D)[i][j];
+        pre = &((elem_t (*)[DIM_J])D)[i0*TILE_I*DIM][j0*TILE_J*DIM];
       }
 
-      for (size_t k = 0; k < DIM_K; k++) {
-        result += A[i][k] * B[k][j];
+      elem_t * out = NULL;
+      if (k0 == K0-1 && C_pixels != 0) {
+        out = tiled_matmul_stage_out(&C[0][0], DIM_J, C_pixels, C_row_len,
+            staged, &stage_slot, i0*TILE_I*DIM, j0*TILE_J*DIM,
+            I*DIM - pad_I_, J*DIM - pad_J_);
+      } else if (k0 == K0-1) {
+        out = &C[i0*TILE_I*DIM][j0*TILE_J*DIM];
       }
 
-      // Shift while rounding to nearest integer (ties round to negative infinity)
-      result = ROUNDING_RIGHT_SHIFT(result, shift);
+      // A bias which isn't full width, or a residual, is staged in the A buffer,
+      // so a resident A tile can only be kept if there's another buffer to
+      // stage it in
+      const int stage_bias = k0 == 0 &&
+        ((!no_bias && !full_bias_width) || res != NULL);
+
+      const int mvin_A = first_mvin || i0 != A_i0 || k0 != A_k0 ||
+        (stage_bias && !double_buffered);
+      const int mvin_B = first_mvin || k0 != B_k0 || j0 != B_j0;
+
+      if (mvin_A) {
+        A_buf = double_buffered && !first_mvin ? !A_buf : A_buf;
+        A_i0 = i0;
+        A_k0 = k0;
+        tiled_matmul_counters.A_loads += (I*DIM - pad_I_) * (K*DIM - pad_K_);
+      }
 
-      // Clip result
-      result = result > elem_t_max ? elem_t_max : (result < elem_t_min ? elem_t_min : result);
+      if (mvin_B) {
+        B_buf = double_buffered && !first_mvin ? !B_buf : B_buf;
+        B_k0 = k0;
+        B_j0 = j0;
+        tiled_matmul_counters.B_loads += (K*DIM - pad_K_) * (J*DIM - pad_J_);
+      }
 
-      // Apply activation function
-      if (act == RELU) {
-        result = result < 0 ? 0 : result;
-      } else if (act == RELU6) {
-        int max = 6 << relu6_shift;
-        result = result < 0 ? 0 : (result > max ? max : result);
+      const int bias_buf = double_buffered && !mvin_A ? !A_buf : A_buf;
+
+      struct prefetch_mvin_t * next = NULL;
+      int prefetch_A = 0, prefetch_B = 0;
+
+      if (!last_mvout) {
+        size_t next_i0, next_j0, next_k0, next_slot, next_group;
+        tiled_matmul_loop_index(loop_order, t+1, I0, J0, K0,
+            &next_i0, &next_j0, &next_k0, &next_slot, &next_group);
+
+        // This tile's outputs can only stay in the accumulator while the next
+        // call runs if that call writes its outputs somewhere else
+        last_mvout = tiled_matmul_acc_addr(next_slot, next_group, acc_tile_rows,
+            acc_double_buffered) == acc_addr;
+
+        // If the scratchpad is double-buffered, the next call's new A and B
+        // tiles can be moved into the other buffers during this call. A tile
+        // that stages a bias can't have its A moved in early, because the bias
+        // is staged in the same buffer.
+        const int next_stage_bias = next_k0 == 0 &&
+          ((!no_bias && !full_bias_width) || res != NULL);
+
+        prefetch_A = double_buffered && !next_stage_bias &&
+          (next_i0 != A_i0 || next_k0 != A_k0);
+        prefetch_B = double_buffered && (next_k0 != B_k0 || next_j0 != B_j0);
+
+        if (prefetch_A || prefetch_B) {
+          sp_tiled_prefetch_init(&next_in,
+              conv ? NULL : &A[next_i0*TILE_I*DIM][next_k0*TILE_K*DIM],
+              &B[next_k0*TILE_K*DIM][next_j0*TILE_J*DIM],
+              conv, next_i0*TILE_I*DIM, next_k0*TILE_K*DIM,
+              next_i0 < I0-1 ? TILE_I : last_I,
+              next_j0 < J0-1 ? TILE_J : last_J,
+              next_k0 < K0-1 ? TILE_K : last_K,
+              next_i0 == I0-1 ? pad_I : 0,
+              next_j0 == J0-1 ? pad_J : 0,
+              next_k0 == K0-1 ? pad_K : 0,
+              DIM_K, DIM_J,
+              A_SP_ADDR_START + !A_buf*SP_BUFFER_ROWS,
+              B_SP_ADDR_START + !B_buf*SP_BUFFER_ROWS,
+              prefetch_A, prefetch_B);
+          next = &next_in;
+        }
       }
 
-      C[i][j] = (elem_t)result;
+      const struct sp_tiled_matmul_t tile = {
+        .A = conv ? NULL : &A[i0*TILE_I*DIM][k0*TILE_K*DIM],
+        .B = &B[k0*TILE_K*DIM][j0*TILE_J*DIM], .D = pre, .C = out,
+        .I = I, .J = J, .K = K, .pad_I = pad_I_, .pad_J = pad_J_, .pad_K = pad_K_,
+        .A_row_len = DIM_K, .B_row_len = DIM_J, .D_row_len = DIM_J, .C_row_len = C_row_len,
+        .A_sp_addr_start = A_SP_ADDR_START + A_buf*SP_BUFFER_ROWS,
+        .B_sp_addr_start = B_SP_ADDR_START + B_buf*SP_BUFFER_ROWS,
+        .bias_sp_addr_start = A_SP_ADDR_START + bias_buf*SP_BUFFER_ROWS,
+        .acc_addr_start = acc_addr,
+        .mvin_A = mvin_A && !A_prefetched, .mvin_B = mvin_B && !B_prefetched,
+        .conv = conv, .conv_row = i0*TILE_I*DIM, .conv_col = k0*TILE_K*DIM,
+        .res = k0 == 0 ? res : NULL, .res_row = i0*TILE_I*DIM, .res_col = j0*TILE_J*DIM,
+        .first_mvin = first_mvin, .last_mvout = last_mvout,
+        .no_bias = no_bias, .full_bias_width = full_bias_width,
+      };
+
+      sp_tiled_matmul(&tile, dataflow, &prev_out, next);
+
+      A_prefetched = prefetch_A;
+      B_prefetched = prefetch_B;
+      prev_out.C = NULL;
+
+      if (out != NULL) {
+        tiled_matmul_counters.C_stores += (I*DIM - pad_I_) * (J*DIM - pad_J_);
+
+        if (!last_mvout) {
+          prev_out = (struct deferred_mvout_t) {
+            .C = out, .C_sp_addr_start = (3 << (ADDR_LEN-2)) | acc_addr,
+            .I = I, .J = J, .pad_I = pad_I_, .pad_J = pad_J_,
+            .C_row_len = C_row_len, .block = 0,
+          };
+        }
+      }
     }
-  }
+
+    matmul_fence();
+
+    for (int slot = 0; slot < 2; slot++)
+      tiled_matmul_unstage_out(&C[0][0], DIM_J, C_pixels, C_row_len,
+          tiled_matmul_out_staging[slot], &staged[slot]);
 }
 
-/*
-static void matmul_cpu(size_t DIM_I, size_t DIM_J, size_t DIM_K,
-        // elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
+static void __attribute__((unused)) tiled_matmul_os(size_t DIM_I, size_t DIM_J, size_t DIM_K,
         elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
-        elem_t C[DIM_I][DIM_J],
+        elem_t C[DIM_I][DIM_J], size_t TILE_I, size_t TILE_J, size_t TILE_K,
+        enum tiled_matmul_loop_order_t loop_order,
         int act, int shift, int relu6_shift, int full_bias_width) {
-  // TODO This function is incorrect. The activation functions, scaling down,
-  // and clipping must be done BEFORE acc_t is cast down to elem_t
-  
-  const int no_bias = D == NULL;
-
-  if (DIM_I % 4 == 0 && DIM_J % 4 == 0) {
-    for (size_t i = 0; i < DIM_I; i += 4) {
-      for (size_t j = 0; j < DIM_J; j += 4) {
-        acc_t result[4][4] = {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
-        for (size_t k = 0; k < DIM_K; k++) {
-          result[0][0] += A[i  ][k] * B[k][j  ];
-          result[0][1] += A[i  ][k] * B[k][j+1];
-          result[0][2] += A[i  ][k] * B[k][j+2];
-          result[0][3] += A[i  ][k] * B[k][j+3];
-
-          result[1][0] += A[i+1][k] * B[k][j  ];
-          result[1][1] += A[i+1][k] * B[k][j+1];
-          result[1][2] += A[i+1][k] * B[k][j+2];
-          result[1][3] += A[i+1][k] * B[k][j+3];
-
-          result[2][0] += A[i+2][k] * B[k][j  ];
-          result[2][1] += A[i+2][k] * B[k][j+1];
-          result[2][2] += A[i+2][k] * B[k][j+2];
-          result[2][3] += A[i+2][k] * B[k][j+3];
-
-          result[3][0] += A[i+3][k] * B[k][j  ];
-          result[3][1] += A[i+3][k] * B[k][j+1];
-          result[3][2] += A[i+3][k] * B[k][j+2];
-          result[3][3] += A[i+3][k] * B[k][j+3];
+    tiled_matmul_conv(DIM_I, DIM_J, DIM_K, A, B, D, C,
+            TILE_I, TILE_J, TILE_K, loop_order, OUTPUT_STATIONARY, NULL, 0, NULL,
+            act, shift, relu6_shift, full_bias_width);
+}
+
+static void __attribute__((unused)) tiled_matmul_ws(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        elem_t C[DIM_I][DIM_J], size_t TILE_I, size_t TILE_J, size_t TILE_K,
+        enum tiled_matmul_loop_order_t loop_order,
+        int act, int shift, int relu6_shift, int full_bias_width) {
+    tiled_matmul_conv(DIM_I, DIM_J, DIM_K, A, B, D, C,
+            TILE_I, TILE_J, TILE_K, loop_order, WEIGHT_STATIONARY, NULL, 0, NULL,
+            act, shift, relu6_shift, full_bias_width);
+}
+
+// Parallel CPU kernels
+//
+// The CPU-side kernels which feed the accelerator (im2col, depthwise convs,
+// pooling and residual adds), and the CPU matmul, split their outer loops over
+// all of the SoC's cores with cpu_parallel_for, which runs fn(args, begin, end) on disjoint
+// ranges that together cover [0, n), and returns once they've all finished.
+//
+// In baremetal builds with MULTITHREAD, the riscv-tests harness calls
+// thread_entry on every hart before main runs on hart 0. The other harts stay
+// in thread_entry, waiting for hart 0 to publish a job. In -linux builds, jobs
+// are handed to a pool of pthreads, one per online core, which is started by
+// the first job. Compile with -DCPU_PARALLEL_THREADS=1 to run everything on
+// the calling core.
+//
+// cpu_parallel_begin hands a job to the other cores only, and returns right
+// away, so that the calling core can drive Gemmini while they work on it.
+// cpu_parallel_wait waits for it to finish, and must be called before the
+// next job is started.
+typedef void (*cpu_parallel_fn_t)(void * args, size_t begin, size_t end);
+
+#ifndef CPU_PARALLEL_MAX_THREADS
+#define CPU_PARALLEL_MAX_THREADS 16
+#endif
+
+// Ranges smaller than this aren't worth waking up the other cores for
+#ifndef CPU_PARALLEL_MIN_ITERS
+#define CPU_PARALLEL_MIN_ITERS 2
+#endif
+
+struct cpu_parallel_job_t {
+  cpu_parallel_fn_t fn;
+  void * args;
+  size_t n;
+
+  // The first core which takes part in the job
+  size_t first;
+};
+
+static volatile struct cpu_parallel_job_t cpu_parallel_job;
+static volatile size_t cpu_parallel_generation, cpu_parallel_done;
+static size_t cpu_parallel_threads = 1;
+
+static void cpu_parallel_run(size_t id, size_t threads) {
+  const size_t first = cpu_parallel_job.first;
+  if (id < first)
+    return;
+
+  id -= first;
+  threads -= first;
+
+  const size_t n = cpu_parallel_job.n;
+  const size_t begin = n * id / threads;
+  const size_t end = n * (id + 1) / threads;
+
+  if (begin < end)
+    cpu_parallel_job.fn(cpu_parallel_job.args, begin, end);
+}
+
+// How many of the given cores the jobs are split over
+static size_t cpu_parallel_limit(long cores) {
+#ifdef CPU_PARALLEL_THREADS
+  cores = cores < CPU_PARALLEL_THREADS ? cores : CPU_PARALLEL_THREADS;
+#endif
+  cores = cores > CPU_PARALLEL_MAX_THREADS ? CPU_PARALLEL_MAX_THREADS : cores;
+  return cores < 1 ? 1 : cores;
+}
+
+// How many cores cpu_parallel_for splits its jobs over. This is worked out
+// once, without starting the pool of workers, so that the planners can use it.
+static size_t cpu_parallel_workers() {
+#if defined(BAREMETAL) && defined(MULTITHREAD) && !defined(CPU_PARALLEL_NO_THREAD_ENTRY)
+  // thread_entry sets this on hart 0 before main runs
+  return cpu_parallel_threads;
+#else
+  static size_t workers;
+
+  if (workers == 0) {
+#ifdef BAREMETAL
+    workers = cpu_parallel_limit(1);
+#else
+    workers = cpu_parallel_limit(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+  }
+
+  return workers;
+#endif
+}
+
+#if defined(BAREMETAL) && defined(MULTITHREAD) && !defined(CPU_PARALLEL_NO_THREAD_ENTRY)
+
+// This is weak, so that it gives way to a thread_entry in another file of the
+// program or its runtime. A program which defines its own in the same file
+// as this header can compile with -DCPU_PARALLEL_NO_THREAD_ENTRY. Either way,
+// jobs then run on hart 0 only.
+void __attribute__((weak)) thread_entry(int cid, int nc) {
+  const size_t threads = cpu_parallel_limit(nc);
+
+  if (cid == 0) {
+    cpu_parallel_threads = threads;
+    return;
+  }
+
+  // Harts which aren't needed stay parked, as they would without this
+  while ((size_t)cid >= threads);
+
+  size_t seen = 0;
+
+  while (1) {
+    while (cpu_parallel_generation == seen);
+    seen = cpu_parallel_generation;
+    __sync_synchronize();
+
+    cpu_parallel_run(cid, threads);
+
+    __sync_synchronize();
+    __sync_fetch_and_add(&cpu_parallel_done, 1);
+  }
+}
+
+static void cpu_parallel_start() {}
+
+#elif !defined(BAREMETAL)
+
+static pthread_mutex_t cpu_parallel_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cpu_parallel_start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t cpu_parallel_done_cond = PTHREAD_COND_INITIALIZER;
+static int cpu_parallel_started;
+
+static void * cpu_parallel_worker(void * arg) {
+  const size_t id = (size_t)arg;
+  size_t seen = 0;
+
+  pthread_mutex_lock(&cpu_parallel_mutex);
+
+  while (1) {
+    while (cpu_parallel_generation == seen)
+      pthread_cond_wait(&cpu_parallel_start_cond, &cpu_parallel_mutex);
+    seen = cpu_parallel_generation;
+    pthread_mutex_unlock(&cpu_parallel_mutex);
+
+    cpu_parallel_run(id, cpu_parallel_threads);
+
+    pthread_mutex_lock(&cpu_parallel_mutex);
+    if (++cpu_parallel_done == cpu_parallel_threads - 1)
+      pthread_cond_signal(&cpu_parallel_done_cond);
+  }
+
+  return NULL;
+}
+
+static void cpu_parallel_start() {
+  if (cpu_parallel_started)
+    return;
+  cpu_parallel_started = 1;
+
+  const size_t threads = cpu_parallel_workers();
+
+  cpu_parallel_threads = 1;
+
+  for (size_t id = 1; id < threads; id++) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, cpu_parallel_worker, (void*)id) != 0)
+      break;
+    pthread_detach(thread);
+    cpu_parallel_threads++;
+  }
+}
+
+#else
+
+static void cpu_parallel_start() {}
+
+#endif
+
+// Publishes a job to the other cores
+static void cpu_parallel_post(size_t n, cpu_parallel_fn_t fn, void * args,
+        size_t first) {
+#ifdef BAREMETAL
+  cpu_parallel_job.fn = fn;
+  cpu_parallel_job.args = args;
+  cpu_parallel_job.n = n;
+  cpu_parallel_job.first = first;
+  cpu_parallel_done = 0;
+  __sync_synchronize();
+  cpu_parallel_generation++;
+#else
+  pthread_mutex_lock(&cpu_parallel_mutex);
+  cpu_parallel_job.fn = fn;
+  cpu_parallel_job.args = args;
+  cpu_parallel_job.n = n;
+  cpu_parallel_job.first = first;
+  cpu_parallel_done = 0;
+  cpu_parallel_generation++;
+  pthread_cond_broadcast(&cpu_parallel_start_cond);
+  pthread_mutex_unlock(&cpu_parallel_mutex);
+#endif
+}
+
+static void __attribute__((unused)) cpu_parallel_wait() {
+  if (cpu_parallel_threads == 1)
+    return;
+
+#ifdef BAREMETAL
+  while (cpu_parallel_done != cpu_parallel_threads - 1);
+  __sync_synchronize();
+#else
+  pthread_mutex_lock(&cpu_parallel_mutex);
+  while (cpu_parallel_done != cpu_parallel_threads - 1)
+    pthread_cond_wait(&cpu_parallel_done_cond, &cpu_parallel_mutex);
+  pthread_mutex_unlock(&cpu_parallel_mutex);
+#endif
+}
+
+static void __attribute__((unused)) cpu_parallel_for(size_t n,
+        cpu_parallel_fn_t fn, void * args) {
+  cpu_parallel_start();
+
+  if (cpu_parallel_threads == 1 || n < CPU_PARALLEL_MIN_ITERS) {
+    fn(args, 0, n);
+    return;
+  }
+
+  cpu_parallel_post(n, fn, args, 0);
+  cpu_parallel_run(0, cpu_parallel_threads);
+  cpu_parallel_wait();
+}
+
+// Returns 0, without starting the job, if there are no other cores to run it
+static int __attribute__((unused)) cpu_parallel_begin(size_t n,
+        cpu_parallel_fn_t fn, void * args) {
+  cpu_parallel_start();
+
+  if (cpu_parallel_threads == 1)
+    return 0;
+
+  cpu_parallel_post(n, fn, args, 1);
+  return 1;
+}
+
+// Scales an accumulated result down to an elem_t the same way Gemmini does
+static elem_t matmul_cpu_scale(acc_t result, int act, int shift, int relu6_shift) {
+  // Shift while rounding to nearest integer (ties round to negative infinity)
+  result = ROUNDING_RIGHT_SHIFT(result, shift);
+
+  // Clip result
+  result = result > elem_t_max ? elem_t_max : (result < elem_t_min ? elem_t_min : result);
+
+  // Apply activation function
+  if (act == RELU) {
+    result = result < 0 ? 0 : result;
+  } else if (act == RELU6) {
+    int max = 6 << relu6_shift;
+    result = result < 0 ? 0 : (result > max ? max : result);
+  }
+
+  return (elem_t)result;
+}
+
+// matmul_cpu_scale on n results at once
+static void matmul_cpu_scale_row(size_t n, const acc_t * in, elem_t * out,
+        int act, int shift, int relu6_shift) {
+  size_t i = 0;
+
+#if GEMMINI_SIMD_BYTES > 0
+  // Clipping to elem_t's range and then applying the activation is a single
+  // clamp to where the two ranges overlap
+  const acc_t relu6_max = 6 << relu6_shift;
+  const acc_t lo = act == RELU || act == RELU6 ? 0 : elem_t_min;
+  const acc_t hi = act == RELU6 && relu6_max < elem_t_max ? relu6_max : elem_t_max;
+
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    acc_vec_t v;
+    memcpy(&v, in + i, sizeof(v));
+    v = SIMD_ROUNDING_RIGHT_SHIFT(v, shift);
+    const elem_vec_t e = SIMD_NARROW(v, lo, hi);
+    memcpy(out + i, &e, sizeof(e));
+  }
+#endif
+
+  for (; i < n; i++)
+    out[i] = matmul_cpu_scale(in[i], act, shift, relu6_shift);
+}
+
+// The CPU matmul computes C a MATMUL_CPU_MR x MATMUL_CPU_NR block at a time,
+// with the block's sums kept in registers. B is packed into panels of NR
+// columns first, with each panel's rows next to each other, so a block reads
+// both of its operands sequentially. As many panels as fit in the packing
+// buffer are packed at a time, and every MR rows of A are multiplied with all
+// of them while those rows are in the cache. The bias, residual, scaling and
+// activation are applied to the acc_t sums, like Gemmini does. The panels, and
+// then the blocks of C, are split over the cores.
+#define MATMUL_CPU_MR 4
+#define MATMUL_CPU_NR 4
+
+#ifndef MATMUL_CPU_PACK_ELEMS
+#define MATMUL_CPU_PACK_ELEMS (1 << 16)
+#endif
+
+static elem_t matmul_cpu_packed_B[MATMUL_CPU_PACK_ELEMS];
+
+struct matmul_cpu_args_t {
+  size_t DIM_I, DIM_J, DIM_K, C_pixels;
+  const elem_t * A, * B;
+  void * D;
+  const struct tiled_matmul_residual_t * res;
+  elem_t * C;
+  int act, shift, relu6_shift, full_bias_width;
+
+  // The rows of C which are computed
+  size_t i0;
+
+  // The columns of B which are being multiplied, and where they are. The
+  // panel of NR columns starting at column j0 + p starts at panels +
+  // p*panel_len, and its rows are panel_row_len apart.
+  size_t j0, cols;
+  const elem_t * panels;
+  size_t panel_len, panel_row_len;
+};
+
+// Packs panels of the packed columns of B, zero-padding the last one
+static void matmul_cpu_pack_B(void * args, size_t begin, size_t end) {
+  const struct matmul_cpu_args_t * const a = args;
+
+  for (size_t panel = begin; panel < end; panel++) {
+    const size_t p = panel * MATMUL_CPU_NR;
+    elem_t * packed = matmul_cpu_packed_B + p*a->DIM_K;
+
+    for (size_t k = 0; k < a->DIM_K; k++) {
+      const elem_t * const row = a->B + k*a->DIM_J + a->j0 + p;
+      for (size_t c = 0; c < MATMUL_CPU_NR; c++)
+        *packed++ = p + c < a->cols ? row[c] : 0;
+    }
+  }
+}
+
+// Multiplies four rows of A with a panel of B, whose rows are b_row_len apart
+static void matmul_cpu_kernel(size_t DIM_K, const elem_t * a0, const elem_t * a1,
+        const elem_t * a2, const elem_t * a3, const elem_t * b, size_t b_row_len,
+        acc_t sums[MATMUL_CPU_MR][MATMUL_CPU_NR]) {
+  acc_t c00 = 0, c01 = 0, c02 = 0, c03 = 0;
+  acc_t c10 = 0, c11 = 0, c12 = 0, c13 = 0;
+  acc_t c20 = 0, c21 = 0, c22 = 0, c23 = 0;
+  acc_t c30 = 0, c31 = 0, c32 = 0, c33 = 0;
+
+  for (size_t k = 0; k < DIM_K; k++, b += b_row_len) {
+    const acc_t b0 = b[0], b1 = b[1], b2 = b[2], b3 = b[3];
+    const acc_t x0 = a0[k], x1 = a1[k], x2 = a2[k], x3 = a3[k];
+
+    c00 += x0*b0; c01 += x0*b1; c02 += x0*b2; c03 += x0*b3;
+    c10 += x1*b0; c11 += x1*b1; c12 += x1*b2; c13 += x1*b3;
+    c20 += x2*b0; c21 += x2*b1; c22 += x2*b2; c23 += x2*b3;
+    c30 += x3*b0; c31 += x3*b1; c32 += x3*b2; c33 += x3*b3;
+  }
+
+  sums[0][0] = c00; sums[0][1] = c01; sums[0][2] = c02; sums[0][3] = c03;
+  sums[1][0] = c10; sums[1][1] = c11; sums[1][2] = c12; sums[1][3] = c13;
+  sums[2][0] = c20; sums[2][1] = c21; sums[2][2] = c22; sums[2][3] = c23;
+  sums[3][0] = c30; sums[3][1] = c31; sums[3][2] = c32; sums[3][3] = c33;
+}
+
+// Adds the bias and residual to a sum, and writes it to C, scaled down
+static void matmul_cpu_store(const struct matmul_cpu_args_t * a,
+        size_t i, size_t j, acc_t result) {
+  const size_t DIM_J = a->DIM_J;
+
+  if (a->D != NULL) {
+    result += a->full_bias_width ? ((acc_t *)a->D)[i*DIM_J + j] :
+      ((elem_t *)a->D)[i*DIM_J + j];
+  }
+
+  result += tiled_matmul_residual_at(a->res, a->shift, i, j);
+
+  const size_t c = a->C_pixels == 0 ? i*DIM_J + j :
+    ((i / a->C_pixels)*DIM_J + j)*a->C_pixels + i % a->C_pixels;
+
+  a->C[c] = matmul_cpu_scale(result, a->act, a->shift, a->relu6_shift);
+}
+
+// Computes blocks of C from the packed panels. Consecutive blocks share their
+// rows of A, and then move on to the next rows.
+static void matmul_cpu_blocks(void * args, size_t begin, size_t end) {
+  const struct matmul_cpu_args_t * const a = args;
+  const size_t MR = MATMUL_CPU_MR, NR = MATMUL_CPU_NR;
+  const size_t panels = (a->cols + NR - 1) / NR;
+
+  for (size_t block = begin; block < end; block++) {
+    const size_t i = a->i0 + (block / panels) * MR;
+    const size_t p = (block % panels) * NR;
+    const size_t rows = a->DIM_I - i < MR ? a->DIM_I - i : MR;
+    const elem_t * const b = a->panels + p*a->panel_len;
+
+    // Rows past the end of A repeat its last row, and their sums are dropped
+    const elem_t * A[MATMUL_CPU_MR];
+    for (size_t r = 0; r < MR; r++)
+      A[r] = a->A + (i + (r < rows ? r : rows - 1))*a->DIM_K;
+
+    acc_t sums[MATMUL_CPU_MR][MATMUL_CPU_NR];
+
+    if (p + NR <= a->cols || a->panel_row_len == NR) {
+      matmul_cpu_kernel(a->DIM_K, A[0], A[1], A[2], A[3], b, a->panel_row_len, sums);
+    } else {
+      // The last panel of an unpacked B is narrower than the kernel
+      for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; p + c < a->cols; c++) {
+          sums[r][c] = 0;
+          for (size_t k = 0; k < a->DIM_K; k++)
+            sums[r][c] += A[r][k] * b[k*a->panel_row_len + c];
         }
-        C[i  ][j  ] = result[0][0];
-        C[i  ][j+1] = result[0][1];
-        C[i  ][j+2] = result[0][2];
-        C[i  ][j+3] = result[0][3];
+      }
+    }
+
+    for (size_t r = 0; r < rows; r++)
+      for (size_t c = 0; c < NR && p + c < a->cols; c++)
+        matmul_cpu_store(a, i + r, a->j0 + p + c, sums[r][c]);
+  }
+}
+
+// Computes rows of C without packing B
+static void matmul_cpu_rows(void * args, size_t begin, size_t end) {
+  const struct matmul_cpu_args_t * const a = args;
+
+  for (size_t i = begin; i < end; i++) {
+    for (size_t j = 0; j < a->DIM_J; j++) {
+      acc_t result = 0;
+      for (size_t k = 0; k < a->DIM_K; k++)
+        result += a->A[i*a->DIM_K + k] * a->B[k*a->DIM_J + j];
+
+      matmul_cpu_store(a, i, j, result);
+    }
+  }
+}
+
+// If C_pixels isn't 0, C is written channel-major, like in tiled_matmul_conv
+static void matmul_cpu_pixels(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
+        elem_t * C, size_t C_pixels,
+        int act, int shift, int relu6_shift, int full_bias_width) {
+  const size_t MR = MATMUL_CPU_MR, NR = MATMUL_CPU_NR;
+  const size_t block_cols = DIM_K == 0 ? DIM_J :
+    MATMUL_CPU_PACK_ELEMS / (DIM_K * NR) * NR;
+
+  struct matmul_cpu_args_t args = {
+    .DIM_I = DIM_I, .DIM_J = DIM_J, .DIM_K = DIM_K, .C_pixels = C_pixels,
+    .A = &A[0][0], .B = &B[0][0], .D = D, .res = res, .C = C,
+    .act = act, .shift = shift, .relu6_shift = relu6_shift,
+    .full_bias_width = full_bias_width,
+    .panels = matmul_cpu_packed_B, .panel_len = DIM_K, .panel_row_len = NR,
+  };
+
+  // If not even one panel fits in the packing buffer, B is read in place
+  if (block_cols == 0) {
+    cpu_parallel_for(DIM_I, matmul_cpu_rows, &args);
+    return;
+  }
+
+  for (size_t j0 = 0; j0 < DIM_J; j0 += block_cols) {
+    args.j0 = j0;
+    args.cols = DIM_J - j0 < block_cols ? DIM_J - j0 : block_cols;
+
+    const size_t panels = (args.cols + NR - 1) / NR;
+    cpu_parallel_for(panels, matmul_cpu_pack_B, &args);
+    cpu_parallel_for(((DIM_I + MR - 1) / MR) * panels, matmul_cpu_blocks, &args);
+  }
+}
+
+static void __attribute__((unused)) matmul_cpu(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        // elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width) {
+  matmul_cpu_pixels(DIM_I, DIM_J, DIM_K, A, B, D, NULL, &C[0][0], 0,
+      act, shift, relu6_shift, full_bias_width);
+}
+
+// Adds a residual to a matmul's output, after the output has been scaled
+// down, for residuals whose scale can't be fused into the matmul
+static void matmul_cpu_add_residual(size_t DIM_I, size_t DIM_J,
+        const struct tiled_matmul_residual_t * res, elem_t C[DIM_I][DIM_J]) {
+  for (size_t i = 0; i < DIM_I; i++)
+    simd_add_shifted(res->cols, res->R + i*res->row_len, res->shift, C[i]);
+}
+
+// A direct convolution on the CPU, with the same layouts as tiled_conv
+static void conv_cpu(size_t batch_size, size_t in_dim, size_t in_channels,
+        size_t out_channels, size_t out_dim,
+        size_t stride, size_t padding, size_t kernel_dim,
+        elem_t input[batch_size][in_dim][in_dim][in_channels],
+        elem_t weights[kernel_dim*kernel_dim*in_channels][out_channels],
+        void * bias, const struct tiled_matmul_residual_t * res,
+        elem_t output[batch_size*out_dim*out_dim][out_channels],
+        int act, int shift, int relu6_shift, int full_bias_width) {
+
+  const int no_bias = bias == NULL;
 
-        C[i+1][j  ] = result[1][0];
-        C[i+1][j+1] = result[1][1];
-        C[i+1][j+2] = result[1][2];
-        C[i+1][j+3] = result[1][3];
+  for (size_t p = 0; p < batch_size*out_dim*out_dim; p++) {
+    const size_t n = p / (out_dim*out_dim);
+    const int oh = (p / out_dim) % out_dim;
+    const int ow = p % out_dim;
 
-        C[i+2][j  ] = result[2][0];
-        C[i+2][j+1] = result[2][1];
-        C[i+2][j+2] = result[2][2];
-        C[i+2][j+3] = result[2][3];
+    for (size_t oc = 0; oc < out_channels; oc++) {
+      acc_t result;
+      if (full_bias_width) {
+        result = no_bias ? 0 : ((acc_t (*)[out_channels])bias)[p][oc];
+      } else {
+        result = no_bias ? 0 : ((elem_t (*)[out_channels])bias)[p][oc];
+      }
 
-        C[i+3][j  ] = result[3][0];
-        C[i+3][j+1] = result[3][1];
-        C[i+3][j+2] = result[3][2];
-        C[i+3][j+3] = result[3][3];
+      result += tiled_matmul_residual_at(res, shift, p, oc);
+
+      for (size_t kh = 0; kh < kernel_dim; kh++) {
+        const int ih = oh*stride - padding + kh;
+        if (ih < 0 || ih >= (int)in_dim)
+          continue;
+
+        for (size_t kw = 0; kw < kernel_dim; kw++) {
+          const int iw = ow*stride - padding + kw;
+          if (iw < 0 || iw >= (int)in_dim)
+            continue;
+
+          for (size_t c = 0; c < in_channels; c++)
+            result += input[n][ih][iw][c] * weights[(kh*kernel_dim + kw)*in_channels + c][oc];
+        }
       }
+
+      output[p][oc] = matmul_cpu_scale(result, act, shift, relu6_shift);
     }
-  } else {
-    for (size_t i = 0; i < DIM_I; i++) {
-      for (size_t j = 0; j < DIM_J; j++) {
-        acc_t result = 0;
-        for (size_t k = 0; k < DIM_K; k++) {
-          result += A[i][k] * B[k][j];
+  }
+}
+
+// A depthwise convolution on the CPU, with the same layouts as tiled_conv_dw.
+// Each output pixel is accumulated for all its channels at once, so the
+// innermost loops run over contiguous runs of channels. The output pixels are
+// split over the cores.
+struct conv_dw_args_t {
+  size_t in_dim, channels, out_dim, stride, padding, kernel_dim;
+  const elem_t * input, * weights;
+  const acc_t * bias;
+  elem_t * output;
+  int act, shift, relu6_shift;
+};
+
+static void conv_dw_cpu_pixels(void * args, size_t begin, size_t end) {
+  const struct conv_dw_args_t * const a = args;
+  const size_t in_dim = a->in_dim, channels = a->channels, out_dim = a->out_dim;
+  const size_t stride = a->stride, padding = a->padding, kernel_dim = a->kernel_dim;
+
+  const elem_t (* const input)[in_dim][in_dim][channels] = (const void*)a->input;
+  const elem_t (* const weights)[kernel_dim][kernel_dim] = (const void*)a->weights;
+  elem_t (* const output)[channels] = (void*)a->output;
+
+  acc_t result[channels];
+
+  for (size_t p = begin; p < end; p++) {
+    const size_t n = p / (out_dim*out_dim);
+    const int oh = (p / out_dim) % out_dim;
+    const int ow = p % out_dim;
+
+    for (size_t c = 0; c < channels; c++)
+      result[c] = a->bias == NULL ? 0 : a->bias[c];
+
+    for (size_t kh = 0; kh < kernel_dim; kh++) {
+      const int ih = oh*stride - padding + kh;
+      if (ih < 0 || ih >= (int)in_dim)
+        continue;
+
+      for (size_t kw = 0; kw < kernel_dim; kw++) {
+        const int iw = ow*stride - padding + kw;
+        if (iw < 0 || iw >= (int)in_dim)
+          continue;
+
+        const elem_t * const in = input[n][ih][iw];
+        for (size_t c = 0; c < channels; c++)
+          result[c] += in[c] * weights[c][kh][kw];
+      }
+    }
+
+    matmul_cpu_scale_row(channels, result, output[p], a->act, a->shift, a->relu6_shift);
+  }
+}
+
+static void conv_dw_cpu(size_t batch_size, size_t in_dim, size_t channels,
+        size_t out_dim, size_t stride, size_t padding, size_t kernel_dim,
+        elem_t input[batch_size][in_dim][in_dim][channels],
+        elem_t weights[channels][kernel_dim][kernel_dim],
+        acc_t * bias, elem_t output[batch_size*out_dim*out_dim][channels],
+        int act, int shift, int relu6_shift) {
+  struct conv_dw_args_t args = {
+    .in_dim = in_dim, .channels = channels, .out_dim = out_dim,
+    .stride = stride, .padding = padding, .kernel_dim = kernel_dim,
+    .input = &input[0][0][0][0], .weights = &weights[0][0][0], .bias = bias,
+    .output = &output[0][0],
+    .act = act, .shift = shift, .relu6_shift = relu6_shift,
+  };
+
+  cpu_parallel_for(batch_size*out_dim*out_dim, conv_dw_cpu_pixels, &args);
+}
+
+// Number of bytes of patch rows which im2col_nchw fills at a time, while the
+// input rows they're copied from are still in the cache
+#ifndef IM2COL_BLOCK_BYTES
+#define IM2COL_BLOCK_BYTES 8192
+#endif
+
+#ifndef IM2COL_CHANNEL_GROUP
+#define IM2COL_CHANNEL_GROUP 8
+#endif
+
+// The arguments of im2col_nchw and im2col_nhwc
+struct im2col_args_t {
+  size_t batch_size, channels, in_dim, out_dim;
+  size_t stride, padding, kernel_dim, out_row_len;
+  const elem_t * input;
+  elem_t * output;
+};
+
+// Builds the patch matrix of a conv on an NCHW input, with one row per output
+// pixel and the columns in (channel, kernel row, kernel col) order. Pixels in
+// the padding are written as zeros.
+//
+// The output is built a block of pixels in one image row at a time, one input
+// channel and kernel row after another, so the input is read a row at a time
+// while the block of patch rows stays in the cache. Output pixels whose
+// kernel row lies entirely inside the image are copied without any bounds
+// checks, and only the ones at the left and right borders are checked.
+//
+// This fills the patch rows of rows [begin, end) of output pixels, where row
+// r is row r % out_dim of image r / out_dim, so that the rows can be split
+// over the cores.
+static void im2col_nchw_rows(void * args, size_t begin, size_t end) {
+  const struct im2col_args_t * const a = args;
+  const size_t channels = a->channels, in_dim = a->in_dim, out_dim = a->out_dim;
+  const size_t stride = a->stride, padding = a->padding, kernel_dim = a->kernel_dim;
+  const size_t K = channels*kernel_dim*kernel_dim;
+
+  const elem_t (* const input)[channels][in_dim][in_dim] = (const void*)a->input;
+  elem_t (* const output)[K] = (void*)a->output;
+
+  size_t block = IM2COL_BLOCK_BYTES / (K * sizeof(elem_t));
+  if (block == 0)
+    block = 1;
+
+  // The output columns in [ow_lo, ow_hi) only read pixels inside the image
+  size_t ow_lo = (padding + stride - 1) / stride;
+  size_t ow_hi = in_dim + padding >= kernel_dim ?
+    (in_dim + padding - kernel_dim) / stride + 1 : 0;
+  ow_hi = ow_hi < out_dim ? ow_hi : out_dim;
+  ow_lo = ow_lo < ow_hi ? ow_lo : ow_hi;
+
+  for (size_t r = begin; r < end; r++) {
+    const size_t n = r / out_dim, oh = r % out_dim;
+    const size_t row = r*out_dim;
+
+    for (size_t ow0 = 0; ow0 < out_dim; ow0 += block) {
+      const size_t ow1 = ow0 + block < out_dim ? ow0 + block : out_dim;
+      const size_t lo = ow_lo < ow0 ? ow0 : (ow_lo > ow1 ? ow1 : ow_lo);
+      const size_t hi = ow_hi > ow1 ? ow1 : (ow_hi < lo ? lo : ow_hi);
+
+      // A 1x1 conv without padding is a transpose of each image row, which
+      // is done a group of channels at a time, so that every patch row is
+      // written in contiguous runs
+      if (kernel_dim == 1 && padding == 0) {
+        const size_t ih = oh*stride;
+        size_t c = 0;
+
+        for (; c + IM2COL_CHANNEL_GROUP <= channels; c += IM2COL_CHANNEL_GROUP) {
+          for (size_t ow = ow0; ow < ow1; ow++) {
+            elem_t * const dst = &output[row + ow][c];
+
+            for (size_t g = 0; g < IM2COL_CHANNEL_GROUP; g++)
+              dst[g] = input[n][c + g][ih][ow*stride];
+          }
+        }
+
+        for (; c < channels; c++)
+          for (size_t ow = ow0; ow < ow1; ow++)
+            output[row + ow][c] = input[n][c][ih][ow*stride];
+
+        continue;
+      }
+
+      for (size_t c = 0; c < channels; c++) {
+        for (size_t kh = 0; kh < kernel_dim; kh++) {
+          const int ih = (int)(oh*stride + kh) - (int)padding;
+          const size_t k = (c*kernel_dim + kh)*kernel_dim;
+
+          if (ih < 0 || ih >= (int)in_dim) {
+            for (size_t ow = ow0; ow < ow1; ow++)
+              for (size_t kw = 0; kw < kernel_dim; kw++)
+                output[row + ow][k + kw] = 0;
+            continue;
+          }
+
+          const elem_t * const in = input[n][c][ih];
+
+          for (size_t ow = ow0; ow < lo; ow++) {
+            for (size_t kw = 0; kw < kernel_dim; kw++) {
+              const int iw = (int)(ow*stride + kw) - (int)padding;
+              output[row + ow][k + kw] = iw < 0 || iw >= (int)in_dim ? 0 : in[iw];
+            }
+          }
+
+          for (size_t ow = lo; ow < hi; ow++) {
+            const elem_t * const src = in + ow*stride - padding;
+            elem_t * const dst = &output[row + ow][k];
+
+            for (size_t kw = 0; kw < kernel_dim; kw++)
+              dst[kw] = src[kw];
+          }
+
+          for (size_t ow = hi; ow < ow1; ow++) {
+            for (size_t kw = 0; kw < kernel_dim; kw++) {
+              const int iw = (int)(ow*stride + kw) - (int)padding;
+              output[row + ow][k + kw] = iw < 0 || iw >= (int)in_dim ? 0 : in[iw];
+            }
+          }
         }
-        C[i][j] = result;
       }
     }
   }
-  for (size_t i = 0; i < DIM_I; i++) {
-    for (size_t j = 0; j < DIM_J; j++) {
-      // acc_t result = C[i][j] + (no_bias ? 0 : D[i][j]);
-      acc_t result = C[i][j];
-      if (!no_bias && full_bias_width) {
-        result += ((acc_t (*)[DIM_J])D)[i][j];
-      } else if (!no_bias && !full_bias_width) {
-        result += ((elem_t (*)[DIM_J])D)[i][j];
-      }
-
-      // Scale value down and round it
-      const int divisor = 1 << shift;
-      acc_t abs = result > 0 ? result : -result;
-      acc_t shifted = (abs + (divisor/2)) / divisor;
-      if (result < 0)
-          result = -shifted;
-      else
-          result = shifted;
+}
+
+static void __attribute__((unused)) im2col_nchw(size_t batch_size, size_t channels, size_t in_dim,
+        size_t out_dim, size_t stride, size_t padding, size_t kernel_dim,
+        const elem_t input[batch_size][channels][in_dim][in_dim],
+        elem_t output[batch_size*out_dim*out_dim][channels*kernel_dim*kernel_dim]) {
+  struct im2col_args_t args = {
+    .batch_size = batch_size, .channels = channels, .in_dim = in_dim,
+    .out_dim = out_dim, .stride = stride, .padding = padding,
+    .kernel_dim = kernel_dim, .out_row_len = channels*kernel_dim*kernel_dim,
+    .input = &input[0][0][0][0], .output = &output[0][0],
+  };
+
+  cpu_parallel_for(batch_size*out_dim, im2col_nchw_rows, &args);
+}
+
+// Builds the patch matrix of a conv on an NHWC input, with one row per output
+// pixel and the columns in (kernel row, kernel col, channel) order, the same
+// order as tiled_conv's weights. Pixels in the padding are written as zeros.
+// Patch rows are out_row_len elements apart, so that they can be written
+// straight into a matrix whose rows are padded.
+//
+// Every kernel position reads a contiguous run of channels, and a kernel row
+// which lies entirely inside the image is a single contiguous run of
+// kernel_dim*channels elements, so this is only a series of copies. Like
+// im2col_nchw, the rows of output pixels are split over the cores.
+static void im2col_nhwc_rows(void * args, size_t begin, size_t end) {
+  const struct im2col_args_t * const a = args;
+  const size_t channels = a->channels, in_dim = a->in_dim, out_dim = a->out_dim;
+  const size_t stride = a->stride, padding = a->padding, kernel_dim = a->kernel_dim;
+  const size_t run = kernel_dim*channels;
+
+  const elem_t (* const input)[in_dim][in_dim][channels] = (const void*)a->input;
+  elem_t (* const output)[a->out_row_len] = (void*)a->output;
+
+  for (size_t r = begin; r < end; r++) {
+    const size_t n = r / out_dim, oh = r % out_dim;
+
+    for (size_t ow = 0; ow < out_dim; ow++) {
+      elem_t * const patch = output[r*out_dim + ow];
+      const int iw0 = (int)(ow*stride) - (int)padding;
+      const int row_inside = iw0 >= 0 && iw0 + kernel_dim <= in_dim;
+
+      for (size_t kh = 0; kh < kernel_dim; kh++) {
+        const int ih = (int)(oh*stride + kh) - (int)padding;
+        elem_t * const dst = patch + kh*run;
+
+        if (ih < 0 || ih >= (int)in_dim) {
+          for (size_t k = 0; k < run; k++)
+            dst[k] = 0;
+          continue;
+        }
 
-      // Clip result
-      result = result > elem_t_max ? elem_t_max : (result < elem_t_min ? elem_t_min : result);
+        if (row_inside) {
+          const elem_t * const src = input[n][ih][iw0];
+          for (size_t k = 0; k < run; k++)
+            dst[k] = src[k];
+          continue;
+        }
+
+        for (size_t kw = 0; kw < kernel_dim; kw++) {
+          const int iw = iw0 + (int)kw;
 
-      // Apply activation function
-      if (act == RELU) {
-        result = result < 0 ? 0 : result;
-      } else if (act == RELU6) {
-        int max = 6 << relu6_shift;
-        result = result < 0 ? 0 : (result > max ? max : result);
+          if (iw < 0 || iw >= (int)in_dim) {
+            for (size_t c = 0; c < channels; c++)
+              dst[kw*channels + c] = 0;
+          } else {
+            for (size_t c = 0; c < channels; c++)
+              dst[kw*channels + c] = input[n][ih][iw][c];
+          }
+        }
       }
+    }
+  }
+}
+
+static void __attribute__((unused)) im2col_nhwc(size_t batch_size, size_t channels, size_t in_dim,
+        size_t out_dim, size_t stride, size_t padding, size_t kernel_dim,
+        const elem_t input[batch_size][in_dim][in_dim][channels],
+        size_t out_row_len,
+        elem_t output[batch_size*out_dim*out_dim][out_row_len]) {
+  struct im2col_args_t args = {
+    .batch_size = batch_size, .channels = channels, .in_dim = in_dim,
+    .out_dim = out_dim, .stride = stride, .padding = padding,
+    .kernel_dim = kernel_dim, .out_row_len = out_row_len,
+    .input = &input[0][0][0][0], .output = &output[0][0],
+  };
+
+  cpu_parallel_for(batch_size*out_dim, im2col_nhwc_rows, &args);
+}
+
+// General matmul which can be run with different dataflows, or on the CPU.
+// AUTO picks one of the first three separately for every matmul, and HYBRID
+// splits every matmul between Gemmini and the CPU (see tiled_matmul_hybrid).
+enum tiled_matmul_type_t {OS, WS, CPU, AUTO, HYBRID};
+
+// Rough costs used to estimate how long a matmul will take, when picking a
+// dataflow in AUTO mode. GEMMINI_CALL_CYCLES covers configuring Gemmini and
+// waiting on the final fence.
+// The CPU costs are per core, and are divided by the number of cores the work
+// is split over. CPU_CYCLES_PER_MAC is the cost of the simple loops, like
+// conv_dw_cpu's, while CPU_MATMUL_CYCLES_PER_KMAC is the cost of 1024 MACs in
+// matmul_cpu's packed register-blocked kernel, which runs about twice as fast.
+#ifndef CPU_CYCLES_PER_MAC
+#define CPU_CYCLES_PER_MAC 2
+#endif
+
+#ifndef CPU_MATMUL_CYCLES_PER_KMAC
+#define CPU_MATMUL_CYCLES_PER_KMAC 1024
+#endif
+
+#ifndef GEMMINI_BYTES_PER_CYCLE
+#define GEMMINI_BYTES_PER_CYCLE 16
+#endif
+
+#ifndef GEMMINI_CALL_CYCLES
+#define GEMMINI_CALL_CYCLES 1000
+#endif
+
+// The tile sizes, loop order and dataflow that tiled_matmul_option will use,
+// together with the DRAM traffic, number of mvin/mvout commands, number of
+// tiles and number of cycles they're expected to cost. Tile sizes are in
+// DIM x DIM blocks.
+struct tiled_matmul_plan_t {
+  size_t tile_i, tile_j, tile_k;
+  enum tiled_matmul_loop_order_t loop_order;
+  enum tiled_matmul_type_t dataflow;
+
+  size_t A_bytes, B_bytes, D_bytes, C_bytes;
+  size_t mem_cmds, tiles, cycles;
+};
+
+static size_t tiled_matmul_plan_bytes(const struct tiled_matmul_plan_t * plan) {
+  return plan->A_bytes + plan->B_bytes + plan->D_bytes + plan->C_bytes;
+}
+
+// The dataflow that tiled_matmul_conv runs an OS or WS plan with
+static int tiled_matmul_plan_dataflow(const struct tiled_matmul_plan_t * plan) {
+  return plan->dataflow == WS ? WEIGHT_STATIONARY : OUTPUT_STATIONARY;
+}
+
+// Fills in the modelled cost of running the tiling functions with the given
+// tile sizes and loop order. Unless the loop order lets consecutive calls
+// share them, sp_tiled_matmul moves in the whole A and B tiles on every
+// call, so A is read once per column of output tiles and B once per row of
+// output tiles. D and C are moved in and out exactly once.
+// The dataflow only changes how the tiles are fed into the array, not what is
+// moved between DRAM and the scratchpad, so it only affects the cycle count.
+static void tiled_matmul_plan_cost(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        int no_bias, int full_bias_width, struct tiled_matmul_plan_t * plan) {
+  const size_t I_blocks = (DIM_I + DIM - 1) / DIM;
+  const size_t J_blocks = (DIM_J + DIM - 1) / DIM;
+  const size_t K_blocks = (DIM_K + DIM - 1) / DIM;
+
+  const size_t I0 = (I_blocks + plan->tile_i - 1) / plan->tile_i;
+  const size_t J0 = (J_blocks + plan->tile_j - 1) / plan->tile_j;
+  const size_t K0 = (K_blocks + plan->tile_k - 1) / plan->tile_k;
+
+  const size_t sizeof_bias = full_bias_width ? sizeof(acc_t) : sizeof(elem_t);
+  const size_t D_blocks_max = full_bias_width ? MAX_BLOCK_LEN_ACC : MAX_BLOCK_LEN;
+
+  size_t A_reloads, B_reloads;
+  tiled_matmul_loop_reloads(plan->loop_order, I0, J0, K0, &A_reloads, &B_reloads);
+
+  plan->A_bytes = DIM_I * DIM_K * sizeof(elem_t) * A_reloads;
+  plan->B_bytes = DIM_K * DIM_J * sizeof(elem_t) * B_reloads;
+  plan->D_bytes = no_bias ? 0 : DIM_I * DIM_J * sizeof_bias;
+  plan->C_bytes = DIM_I * DIM_J * sizeof(elem_t);
+
+  // Each mvin moves DIM rows of up to MAX_BLOCK_LEN blocks, and each mvout
+  // moves up to MAX_BLOCK_LEN_ST blocks. Summed over all tiles, a row of
+  // blocks which is tiled into chunks of T is moved with one command per
+  // max_len blocks of each chunk.
+#define row_cmds(blocks, tile, max_len) \
+  (((blocks) / (tile)) * (((tile) + (max_len) - 1) / (max_len)) + \
+   ((((blocks) % (tile)) + (max_len) - 1) / (max_len)))
+
+  const size_t A_cmds = I_blocks * row_cmds(K_blocks, plan->tile_k, MAX_BLOCK_LEN) * A_reloads;
+  const size_t B_cmds = K_blocks * row_cmds(J_blocks, plan->tile_j, MAX_BLOCK_LEN) * B_reloads;
+  const size_t D_cmds = no_bias ? 0 : I_blocks * row_cmds(J_blocks, plan->tile_j, D_blocks_max);
+  const size_t C_cmds = I_blocks * row_cmds(J_blocks, plan->tile_j, MAX_BLOCK_LEN_ST);
+
+#undef row_cmds
+
+  plan->mem_cmds = A_cmds + B_cmds + D_cmds + C_cmds;
+  plan->tiles = I0 * J0 * K0;
+
+  // Every block of the matmul takes DIM cycles to stream through the array.
+  // On top of that, OS has to preload every output block once per k0 tile,
+  // while WS has to preload every weight block once per i0 tile. A bias which
+  // isn't full width also has to pass through the array once, to be widened
+  // into the accumulator. The scratchpad is double-buffered, so the transfers
+  // overlap with the compute.
+  const size_t compute_cycles = I_blocks * J_blocks * K_blocks * DIM;
+  const size_t preload_cycles = plan->dataflow == WS ?
+    J_blocks * K_blocks * I0 * DIM : I_blocks * J_blocks * K0 * DIM;
+  const size_t bias_cycles = no_bias || full_bias_width ? 0 : I_blocks * J_blocks * DIM;
+  const size_t mem_cycles = tiled_matmul_plan_bytes(plan) / GEMMINI_BYTES_PER_CYCLE;
+
+  if (plan->dataflow == CPU) {
+    plan->cycles = DIM_I * DIM_J * DIM_K * CPU_MATMUL_CYCLES_PER_KMAC /
+      (1024 * cpu_parallel_workers());
+  } else {
+    const size_t array_cycles = compute_cycles + preload_cycles + bias_cycles;
+    plan->cycles = (array_cycles > mem_cycles ? array_cycles : mem_cycles) +
+      GEMMINI_CALL_CYCLES;
+  }
+}
+
+// Returns whether plan a is expected to be cheaper than plan b. Plans are
+// compared by their modelled DRAM traffic, then by the number of mvin/mvout
+// commands, and then by the number of tiles.
+static int tiled_matmul_plan_better(const struct tiled_matmul_plan_t * a,
+        const struct tiled_matmul_plan_t * b) {
+  const size_t a_bytes = tiled_matmul_plan_bytes(a);
+  const size_t b_bytes = tiled_matmul_plan_bytes(b);
+
+  if (a_bytes != b_bytes)
+    return a_bytes < b_bytes;
+  if (a->mem_cmds != b->mem_cmds)
+    return a->mem_cmds < b->mem_cmds;
+  return a->tiles < b->tiles;
+}
+
+// Whether tiles of tile_i x tile_j x tile_k blocks, visited in loop_order,
+// let the tiling functions double-buffer the scratchpad and keep every
+// resident output tile in the accumulator
+static int tiled_matmul_plan_fits(size_t I_blocks, size_t J_blocks,
+        size_t K_blocks, size_t tile_i, size_t tile_j, size_t tile_k,
+        enum tiled_matmul_loop_order_t loop_order) {
+  const size_t mats_in_acc = ACC_BUFFER_ROWS / DIM;
+  const size_t mats_in_partition = SP_BUFFER_ROWS / DIM;
+  const size_t max_tile = tile_i > tile_j ? tile_i : tile_j;
+
+  if (tile_i == 0 || tile_j == 0 || tile_k == 0 ||
+      tile_i * tile_j > mats_in_acc || max_tile * tile_k > mats_in_partition ||
+      loop_order > LOOP_KJI || !sp_tiles_fit_double_buffered(tile_i, tile_j, tile_k))
+    return 0;
+
+  const size_t I0 = (I_blocks + tile_i - 1) / tile_i;
+  const size_t J0 = (J_blocks + tile_j - 1) / tile_j;
+  const size_t K0 = (K_blocks + tile_k - 1) / tile_k;
+
+  return tiled_matmul_loop_resident_tiles(loop_order, I0, J0, K0) * tile_i * tile_j <=
+    mats_in_acc;
+}
+
+// Fills plans with the max_plans cheapest tilings and loop orders which still
+// let the tiling functions double-buffer the scratchpad and accumulator,
+// cheapest first, and returns how many were found. tile_k doesn't change the
+// traffic, so it's always as large as the scratchpad allows.
+static size_t tiled_matmul_plan_candidates(size_t DIM_I, size_t DIM_J,
+        size_t DIM_K, int no_bias, int full_bias_width,
+        enum tiled_matmul_type_t dataflow,
+        struct tiled_matmul_plan_t plans[], size_t max_plans) {
+  const size_t I_blocks = (DIM_I + DIM - 1) / DIM;
+  const size_t J_blocks = (DIM_J + DIM - 1) / DIM;
+  const size_t K_blocks = (DIM_K + DIM - 1) / DIM;
+
+  const size_t mats_in_acc = ACC_BUFFER_ROWS / DIM;
+  const size_t mats_in_partition = SP_BUFFER_ROWS / DIM;
+
+  size_t n_plans = 0;
+
+  if (max_plans == 0)
+    return 0;
+
+  if (dataflow == CPU) {
+    plans[0] = (struct tiled_matmul_plan_t) { .tile_i = 1, .tile_j = 1,
+      .tile_k = 1, .dataflow = dataflow };
+    tiled_matmul_plan_cost(DIM_I, DIM_J, DIM_K, no_bias, full_bias_width, &plans[0]);
+    return 1;
+  }
 
-      C[i][j] = (elem_t)result;
+  for (size_t tile_i = 1; tile_i <= I_blocks && tile_i <= mats_in_acc; tile_i++) {
+    for (size_t tile_j = 1; tile_j <= J_blocks && tile_i * tile_j <= mats_in_acc; tile_j++) {
+      const size_t max_tile_k = mats_in_partition / (tile_i > tile_j ? tile_i : tile_j);
+      const size_t tile_k = K_blocks < max_tile_k ? K_blocks : max_tile_k;
+
+      for (enum tiled_matmul_loop_order_t loop_order = LOOP_IJK;
+          loop_order <= LOOP_KJI; loop_order++) {
+        if (!tiled_matmul_plan_fits(I_blocks, J_blocks, K_blocks,
+              tile_i, tile_j, tile_k, loop_order))
+          continue;
+
+        struct tiled_matmul_plan_t plan = { .tile_i = tile_i, .tile_j = tile_j,
+          .tile_k = tile_k, .loop_order = loop_order, .dataflow = dataflow };
+        tiled_matmul_plan_cost(DIM_I, DIM_J, DIM_K, no_bias, full_bias_width, &plan);
+
+        // Insert the plan into the sorted list, dropping the most expensive
+        // plan if the list is already full
+        size_t pos = n_plans;
+        while (pos > 0 && tiled_matmul_plan_better(&plan, &plans[pos-1]))
+          pos--;
+
+        if (pos >= max_plans)
+          continue;
+
+        if (n_plans < max_plans)
+          n_plans++;
+
+        for (size_t p = n_plans-1; p > pos; p--)
+          plans[p] = plans[p-1];
+        plans[pos] = plan;
+      }
     }
   }
+
+  return n_plans;
 }
-*/
 
-// General matmul which can be run with different dataflows, or on the CPU
-enum tiled_matmul_type_t {OS, WS, CPU};
+// Picks the tiling with the least modelled DRAM traffic. In AUTO mode, it
+// also picks whichever of OS, WS and CPU is expected to take the fewest
+// cycles. In HYBRID mode, it picks between OS and WS, for the part of the
+// matmul which runs on Gemmini.
+static struct tiled_matmul_plan_t tiled_matmul_plan(size_t DIM_I, size_t DIM_J,
+        size_t DIM_K, int no_bias, int full_bias_width,
+        enum tiled_matmul_type_t dataflow) {
+  if (dataflow == AUTO || dataflow == HYBRID) {
+    struct tiled_matmul_plan_t best = tiled_matmul_plan(DIM_I, DIM_J, DIM_K,
+        no_bias, full_bias_width, OS);
+
+    // OS and WS share the same tiling, since their traffic is identical
+    struct tiled_matmul_plan_t ws = best;
+    ws.dataflow = WS;
+    tiled_matmul_plan_cost(DIM_I, DIM_J, DIM_K, no_bias, full_bias_width, &ws);
+
+    if (ws.cycles < best.cycles)
+      best = ws;
+
+    if (dataflow == AUTO) {
+      const struct tiled_matmul_plan_t cpu = tiled_matmul_plan(DIM_I, DIM_J, DIM_K,
+          no_bias, full_bias_width, CPU);
+
+      if (cpu.cycles < best.cycles)
+        best = cpu;
+    }
+
+    return best;
+  }
+
+  struct tiled_matmul_plan_t plan = { .tile_i = 1, .tile_j = 1, .tile_k = 1,
+    .dataflow = dataflow };
+
+  if (tiled_matmul_plan_candidates(DIM_I, DIM_J, DIM_K, no_bias,
+        full_bias_width, dataflow, &plan, 1) == 0) {
+    tiled_matmul_plan_cost(DIM_I, DIM_J, DIM_K, no_bias, full_bias_width, &plan);
+  }
+
+  return plan;
+}
+
+static void __attribute__((unused)) print_tiled_matmul_plan(const struct tiled_matmul_plan_t * plan) {
+  const char * dataflows[] = {"OS", "WS", "CPU", "AUTO", "HYBRID"};
+
+  printf("dataflow: %s, tile_i: %lu, tile_j: %lu, tile_k: %lu, loop order: %s\n",
+      dataflows[plan->dataflow], plan->tile_i, plan->tile_j, plan->tile_k,
+      tiled_matmul_loop_vars[plan->loop_order]);
+  printf("  bytes: %lu (A: %lu, B: %lu, D: %lu, C: %lu), mvin/mvout cmds: %lu, cycles: %lu\n",
+      tiled_matmul_plan_bytes(plan), plan->A_bytes, plan->B_bytes,
+      plan->D_bytes, plan->C_bytes, plan->mem_cmds, plan->cycles);
+}
+
+// A tiling which was measured to be fastest for a specific matmul. These are
+// generated by building with GEMMINI_TUNE, and are listed in gemmini_tuned.h.
+struct tiled_matmul_tuned_t {
+  size_t I, J, K;
+  int act, full_bias_width;
+  size_t tile_i, tile_j, tile_k;
+  enum tiled_matmul_type_t dataflow;
+  enum tiled_matmul_loop_order_t loop_order;
+};
+
+#include "include/gemmini_tuned.h"
+
+static const struct tiled_matmul_tuned_t * tiled_matmul_tuned_lookup(size_t DIM_I,
+        size_t DIM_J, size_t DIM_K, int act, int full_bias_width) {
+  for (size_t t = 0; t < TILED_MATMUL_TUNED_ENTRIES; t++) {
+    const struct tiled_matmul_tuned_t * tuned = &tiled_matmul_tuned[t];
+
+    if (tuned->I == DIM_I && tuned->J == DIM_J && tuned->K == DIM_K &&
+        tuned->act == act && tuned->full_bias_width == full_bias_width)
+      return tuned;
+  }
+
+  return NULL;
+}
+
+// The planner's choice, overridden by gemmini_tuned.h if the matmul is listed
+// there. Tuned tile sizes are used with either dataflow, since OS and WS move
+// the same data in and out of the scratchpad. In AUTO and HYBRID mode, the
+// tuned dataflow is used as well, unless it's CPU and the mode is HYBRID.
+// Entries are only timed through tiled_matmul_residual, but tiled_conv and
+// tiled_matmul_option_nchw look them up too, so every entry goes through the
+// same capacity check as the planner's own tilings.
+static struct tiled_matmul_plan_t tiled_matmul_plan_tuned(size_t DIM_I,
+        size_t DIM_J, size_t DIM_K, int no_bias, int act, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+    struct tiled_matmul_plan_t plan = tiled_matmul_plan(DIM_I, DIM_J, DIM_K,
+            no_bias, full_bias_width, tiled_matmul_type);
+
+    const struct tiled_matmul_tuned_t * tuned = tiled_matmul_tuned_lookup(DIM_I,
+            DIM_J, DIM_K, act, full_bias_width);
+
+    if (tuned != NULL && tuned->dataflow == CPU && tiled_matmul_type != AUTO) {
+        tuned = NULL;
+    }
 
-// TODO add support for non-divisible tiling factors
-static size_t tiling_factor(const size_t dimension, const size_t max_tile_factor) {
-    const size_t start = dimension < max_tile_factor ? dimension : max_tile_factor;
+    if (tuned != NULL && tuned->dataflow != CPU &&
+        !tiled_matmul_plan_fits((DIM_I + DIM - 1) / DIM, (DIM_J + DIM - 1) / DIM,
+            (DIM_K + DIM - 1) / DIM, tuned->tile_i, tuned->tile_j, tuned->tile_k,
+            tuned->loop_order)) {
+        tuned = NULL;
+    }
 
-    for (size_t tile_factor = start; tile_factor >= 1; tile_factor--) {
-        if (dimension % tile_factor == 0)
-            return tile_factor;
+    if (tuned != NULL && tiled_matmul_type != CPU) {
+        if (tiled_matmul_type == AUTO || tiled_matmul_type == HYBRID) {
+            plan.dataflow = tuned->dataflow;
+        }
+        plan.tile_i = tuned->tile_i;
+        plan.tile_j = tuned->tile_j;
+        plan.tile_k = tuned->tile_k;
+        plan.loop_order = tuned->loop_order;
+        tiled_matmul_plan_cost(DIM_I, DIM_J, DIM_K, no_bias, full_bias_width, &plan);
     }
-    return 1; // We should never reach here anyway
+
+    return plan;
 }
 
-static void __attribute__((unused)) tiled_matmul_option(size_t DIM_I, size_t DIM_J, size_t DIM_K,
-        // elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
+static void tiled_matmul_with_plan(size_t DIM_I, size_t DIM_J, size_t DIM_K,
         elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
         elem_t C[DIM_I][DIM_J],
         int act, int shift, int relu6_shift, int full_bias_width,
-        enum tiled_matmul_type_t tiled_matmul_type) {
-    // const int partition_rows = BANK_NUM * BANK_ROWS / 2;
-    // const int mats_in_partition = partition_rows / DIM;
-    // const int mats_in_acc = ACC_ROWS / DIM;
-    // const int max_tile_i_j = (int)sqrt(mats_in_acc);
-    // const int max_tile_k = mats_in_partition / max_tile_i_j;
-
-    // We use macros here instead of "const int" so that GCC const-folds sqrt
-#define partition_rows (BANK_NUM * BANK_ROWS / 2)
-#define mats_in_partition (partition_rows / DIM)
-#define mats_in_acc (ACC_ROWS / DIM)
-#define max_tile_i_j ((int)sqrt(mats_in_acc))
-#define max_tile_k (mats_in_partition / max_tile_i_j)
-
-    const size_t tile_i = tiling_factor(DIM_I/DIM, max_tile_i_j);
-    const size_t tile_j = tiling_factor(DIM_J/DIM, max_tile_i_j);
-    const size_t tile_k = tiling_factor(DIM_K/DIM, max_tile_k);
-
-    // printf("tile_i: %lu\n", tile_i);
-    // printf("tile_j: %lu\n", tile_j);
-    // printf("tile_k: %lu\n", tile_k);
-
-    if (tiled_matmul_type == OS) {
-        tiled_matmul_os(DIM_I, DIM_J, DIM_K,
+        const struct tiled_matmul_plan_t * plan) {
+    const struct tiled_matmul_residual_t * fused =
+        tiled_matmul_residual_fused(res, shift) ? res : NULL;
+
+    if (plan->dataflow == OS || plan->dataflow == WS) {
+        tiled_matmul_conv(DIM_I, DIM_J, DIM_K,
                 A, B, D, C,
-                tile_i, tile_j, tile_k,
-                act, shift, relu6_shift, full_bias_width);
-    } else if (tiled_matmul_type == WS) {
-        tiled_matmul_ws(DIM_I, DIM_J, DIM_K,
-                A, B, (acc_t (*)[DIM_J])D, C,
-                tile_i, tile_j, tile_k,
+                plan->tile_i, plan->tile_j, plan->tile_k, plan->loop_order,
+                tiled_matmul_plan_dataflow(plan), NULL, 0, fused,
                 act, shift, relu6_shift, full_bias_width);
-    } else /*if (tiled_matmul_type == CPU)*/ {
-        matmul_cpu(DIM_I, DIM_J, DIM_K,
-                A, B, (acc_t (*)[DIM_J])D, C,
+    } else /*if (plan->dataflow == CPU)*/ {
+        matmul_cpu_pixels(DIM_I, DIM_J, DIM_K,
+                A, B, D, fused, &C[0][0], 0,
                 act, shift, relu6_shift, full_bias_width);
     }/* else {
         printf("unknown tiled matrix type");
         exit(1);
     }*/
 
-#undef partition_rows
-#undef mats_in_partition
-#undef mats_in_acc
-#undef max_tile_i_j
-#undef max_tile_k
+    if (res != NULL && fused == NULL)
+        matmul_cpu_add_residual(DIM_I, DIM_J, res, C);
+}
+
+// HYBRID runs the first rows of a matmul's output on Gemmini, and hands the
+// rest to the other cores, which would otherwise sit at the fence. The split
+// falls between blocks of DIM rows, at the point where both sides are
+// expected to finish together, going by how fast each side was measured to
+// be on the previous HYBRID matmuls. Compile with -DHYBRID_CPU_PERCENT=n to
+// always give the CPU n% of the blocks instead. With only one core, everything
+// runs on Gemmini.
+//
+// The CPU's speed is kept in cycles per 1024 MACs over all of the other
+// cores. Gemmini's speed depends a lot more on the matmul's shape, so it's
+// kept as the cycles it took per 1024 cycles which the plan's cost model
+// expected it to take.
+struct tiled_matmul_hybrid_rates_t {
+  unsigned long cpu_cycles_per_kmac, gemmini_cycles_per_kmodel;
+};
+
+static struct tiled_matmul_hybrid_rates_t tiled_matmul_hybrid_rates;
+
+struct tiled_matmul_hybrid_args_t {
+  struct matmul_cpu_args_t cpu;
+
+  // When the last of the cores finished
+  volatile unsigned long end;
+};
+
+static void tiled_matmul_hybrid_cpu(void * args, size_t begin, size_t end) {
+  struct tiled_matmul_hybrid_args_t * const h = args;
+
+  matmul_cpu_blocks(&h->cpu, begin, end);
+
+  const unsigned long now = read_cycles();
+  unsigned long last = h->end;
+  while (now > last && !__sync_bool_compare_and_swap(&h->end, last, now))
+    last = h->end;
+}
+
+static void tiled_matmul_hybrid(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        const struct tiled_matmul_plan_t * plan) {
+    const size_t MR = MATMUL_CPU_MR, NR = MATMUL_CPU_NR;
+    struct tiled_matmul_hybrid_rates_t * const rates = &tiled_matmul_hybrid_rates;
+
+    cpu_parallel_start();
+    const size_t cores = cpu_parallel_threads - 1;
+
+    if (rates->cpu_cycles_per_kmac == 0 && cores > 0) {
+        rates->cpu_cycles_per_kmac = (CPU_MATMUL_CYCLES_PER_KMAC + cores - 1) / cores;
+        rates->gemmini_cycles_per_kmodel = 1024;
+    }
+
+    const size_t tiles = (DIM_I + DIM - 1) / DIM;
+
+#ifdef HYBRID_CPU_PERCENT
+    size_t cpu_tiles = cores == 0 ? 0 : (tiles * HYBRID_CPU_PERCENT + 50) / 100;
+#else
+    const unsigned long gemmini_cycles =
+      plan->cycles * rates->gemmini_cycles_per_kmodel / 1024;
+    const unsigned long cpu_cycles =
+      DIM_I * DIM_J * DIM_K * rates->cpu_cycles_per_kmac / 1024;
+    const unsigned long total_cycles = gemmini_cycles + cpu_cycles;
+
+    size_t cpu_tiles = cores == 0 || total_cycles == 0 ? 0 :
+      (tiles * gemmini_cycles + total_cycles / 2) / total_cycles;
+#endif
+
+    cpu_tiles = cpu_tiles < tiles ? cpu_tiles : tiles;
+
+    const size_t gemmini_rows = (tiles - cpu_tiles) * DIM < DIM_I ?
+      (tiles - cpu_tiles) * DIM : DIM_I;
+
+    if (gemmini_rows == 0) {
+        struct tiled_matmul_plan_t cpu = *plan;
+        cpu.dataflow = CPU;
+        tiled_matmul_with_plan(DIM_I, DIM_J, DIM_K, A, B, D, res, C,
+                act, shift, relu6_shift, full_bias_width, &cpu);
+        return;
+    }
+
+    const struct tiled_matmul_residual_t * fused =
+        tiled_matmul_residual_fused(res, shift) ? res : NULL;
+
+    // The CPU reads B in place, so that the cores don't share a packing buffer
+    struct tiled_matmul_hybrid_args_t args = {
+      .cpu = {
+        .DIM_I = DIM_I, .DIM_J = DIM_J, .DIM_K = DIM_K,
+        .A = &A[0][0], .B = &B[0][0], .D = D, .res = fused, .C = &C[0][0],
+        .act = act, .shift = shift, .relu6_shift = relu6_shift,
+        .full_bias_width = full_bias_width,
+        .i0 = gemmini_rows, .j0 = 0, .cols = DIM_J,
+        .panels = &B[0][0], .panel_len = 1, .panel_row_len = DIM_J,
+      },
+      .end = 0,
+    };
+
+    const size_t strips = (DIM_I - gemmini_rows + MR - 1) / MR;
+    const size_t panels = (DIM_J + NR - 1) / NR;
+    const int split = gemmini_rows < DIM_I;
+
+    const struct tiled_matmul_plan_t gemmini_plan = !split ? *plan :
+      tiled_matmul_plan(gemmini_rows, DIM_J, DIM_K, D == NULL, full_bias_width,
+          plan->dataflow);
+
+    const unsigned long start = read_cycles();
+    if (split)
+        cpu_parallel_begin(strips * panels, tiled_matmul_hybrid_cpu, &args);
+
+    tiled_matmul_with_plan(gemmini_rows, DIM_J, DIM_K, A, B, D, fused, C,
+            act, shift, relu6_shift, full_bias_width, &gemmini_plan);
+    const unsigned long gemmini_end = read_cycles();
+
+    if (split)
+        cpu_parallel_wait();
+
+#ifndef HYBRID_CPU_PERCENT
+    // Each measurement is averaged with the previous estimate. Gemmini is
+    // measured even when it runs the whole matmul, so that the CPU gets a share
+    // once Gemmini turns out to be slower than expected.
+    const unsigned long cpu_macs = (DIM_I - gemmini_rows) * DIM_J * DIM_K;
+
+    if (gemmini_end > start && gemmini_plan.cycles > 0) {
+        const unsigned long measured = (gemmini_end - start) * 1024 / gemmini_plan.cycles;
+        rates->gemmini_cycles_per_kmodel = (rates->gemmini_cycles_per_kmodel + measured + 1) / 2;
+    }
+
+    if (args.end > start && cpu_macs > 0) {
+        const unsigned long measured = (args.end - start) * 1024 / cpu_macs;
+        rates->cpu_cycles_per_kmac = (rates->cpu_cycles_per_kmac + measured + 1) / 2;
+    }
+#endif
+
+    if (res != NULL && fused == NULL)
+        matmul_cpu_add_residual(DIM_I, DIM_J, res, C);
+}
+
+// Number of the planner's cheapest tilings which the tuner times, per dataflow
+#ifndef TUNE_CANDIDATES
+#define TUNE_CANDIDATES 8
+#endif
+
+// Times the cheapest few tilings from the planner on both dataflows, as well
+// as the CPU, and prints the fastest one as an entry for gemmini_tuned.h. C is
+// written by every run, so it holds the correct result afterwards.
+static void __attribute__((unused)) tiled_matmul_tune(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width) {
+    const char * dataflows[] = {"OS", "WS", "CPU", "AUTO", "HYBRID"};
+    const char * loop_orders[] = {"LOOP_IJK", "LOOP_IKJ", "LOOP_JIK", "LOOP_JKI",
+      "LOOP_KIJ", "LOOP_KJI"};
+
+    struct tiled_matmul_plan_t best = { .tile_i = 0 };
+    unsigned long best_cycles = ULONG_MAX;
+
+    for (enum tiled_matmul_type_t dataflow = OS; dataflow <= CPU; dataflow++) {
+        struct tiled_matmul_plan_t plans[TUNE_CANDIDATES];
+        const size_t n_plans = tiled_matmul_plan_candidates(DIM_I, DIM_J, DIM_K,
+                D == NULL, full_bias_width, dataflow, plans, TUNE_CANDIDATES);
+
+        for (size_t p = 0; p < n_plans; p++) {
+            const unsigned long start = read_cycles();
+            tiled_matmul_with_plan(DIM_I, DIM_J, DIM_K, A, B, D, res, C,
+                    act, shift, relu6_shift, full_bias_width, &plans[p]);
+            const unsigned long cycles = read_cycles() - start;
+
+            if (cycles < best_cycles) {
+                best = plans[p];
+                best_cycles = cycles;
+            }
+        }
+    }
+
+    printf("  {%lu, %lu, %lu, %d, %d, %lu, %lu, %lu, %s, %s}, // %lu cycles\n",
+            DIM_I, DIM_J, DIM_K, act, full_bias_width,
+            best.tile_i, best.tile_j, best.tile_k, dataflows[best.dataflow],
+            loop_orders[best.loop_order], best_cycles);
+}
+
+// Like tiled_matmul_option, but res is also added to C, inside the
+// accumulator. See tiled_matmul_residual_t.
+static void __attribute__((unused)) tiled_matmul_residual(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+#ifdef GEMMINI_TUNE
+    if (tiled_matmul_type != CPU) {
+        tiled_matmul_tune(DIM_I, DIM_J, DIM_K, A, B, D, res, C,
+                act, shift, relu6_shift, full_bias_width);
+        return;
+    }
+#endif
+
+    struct tiled_matmul_plan_t plan = tiled_matmul_plan_tuned(DIM_I, DIM_J,
+            DIM_K, D == NULL, act, full_bias_width, tiled_matmul_type);
+
+    // print_tiled_matmul_plan(&plan);
+
+    if (tiled_matmul_type == HYBRID) {
+        tiled_matmul_hybrid(DIM_I, DIM_J, DIM_K, A, B, D, res, C,
+                act, shift, relu6_shift, full_bias_width, &plan);
+        return;
+    }
+
+    tiled_matmul_with_plan(DIM_I, DIM_J, DIM_K, A, B, D, res, C,
+            act, shift, relu6_shift, full_bias_width, &plan);
+}
+
+static void __attribute__((unused)) tiled_matmul_option(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        // elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+    tiled_matmul_residual(DIM_I, DIM_J, DIM_K, A, B, D, NULL, C,
+            act, shift, relu6_shift, full_bias_width, tiled_matmul_type);
+}
+
+// Checksum verification
+//
+// tiled_matmul_verify checks the output of tiled_matmul_residual without
+// recomputing all of it. The sums of every row and every column of the
+// accumulator, before it's scaled down, are computed exactly from the row sums
+// of B and the column sums of A, in O(I*K + K*J + I*J) time. C only holds the
+// scaled down outputs, but matmul_cpu_scale never decreases, so every output
+// bounds the accumulator value it came from, and the sums have to lie between
+// the sums of those bounds. That catches every error which moves a sum by
+// more than the rounding and saturation of its row or column can hide, so
+// VERIFY_SAMPLED_TILES DIM x DIM tiles of C are also recomputed exactly, to
+// catch small errors too. If there are no more tiles than that, every tile is
+// recomputed, which makes this a full comparison against the CPU.
+//
+// The sums of A and B are taken VERIFY_CHUNK values of K at a time, for
+// VERIFY_CHUNK rows or columns at a time, so they need no more than a fixed
+// amount of memory. When K doesn't fit in one chunk, that costs a pass over B
+// for every VERIFY_CHUNK rows, and a pass over A for every VERIFY_CHUNK
+// columns.
+//
+// An activation leaves an output of 0 with no lower bound on the accumulator,
+// so on its own, the checksum of an activated layer can't see an error which
+// pushes outputs down to 0. For those layers, a band of VERIFY_SAMPLED_ROWS
+// rows is also rerun on Gemmini with NO_ACTIVATION. The rerun's sums have
+// bounds on both sides, and C's rows have to match its activated outputs.
+// Layers with more than VERIFY_SCRATCH_ELEMS / VERIFY_SAMPLED_ROWS columns
+// rerun fewer rows.
+//
+// The sums are 64 bits wide, so accumulator values which overflow acc_t show
+// up as errors, even though Gemmini and the CPU would agree on them.
+#ifndef VERIFY_SAMPLED_TILES
+#define VERIFY_SAMPLED_TILES 4
+#endif
+
+#ifndef VERIFY_CHUNK
+#define VERIFY_CHUNK 256
+#endif
+
+#ifndef VERIFY_SAMPLED_ROWS
+#define VERIFY_SAMPLED_ROWS DIM
+#endif
+
+#ifndef VERIFY_SCRATCH_ELEMS
+#define VERIFY_SCRATCH_ELEMS (DIM * 4096)
+#endif
+
+// The sum of accumulator values, and the bounds on it from the outputs
+struct tiled_matmul_verify_sum_t {
+  int64_t exact, lo, hi;
+  int lo_unbounded, hi_unbounded;
+};
+
+static int64_t tiled_matmul_verify_k_sums[VERIFY_CHUNK];
+static struct tiled_matmul_verify_sum_t tiled_matmul_verify_sums[VERIFY_CHUNK];
+static elem_t tiled_matmul_verify_scratch[VERIFY_SCRATCH_ELEMS] row_align(1);
+
+// Adds the bounds on the accumulator value which matmul_cpu_scale maps to
+// some output in [y_lo, y_hi]. Returns 0 if no accumulator value can give
+// an output in that range.
+static int tiled_matmul_verify_add(struct tiled_matmul_verify_sum_t * sum,
+        int64_t y_lo, int64_t y_hi, int act, int shift, int relu6_shift) {
+  const int64_t relu6_max = (int64_t)6 << relu6_shift;
+  const int64_t y_min = act == RELU || act == RELU6 ? 0 : elem_t_min;
+  const int64_t y_max = act == RELU6 && relu6_max < elem_t_max ? relu6_max : elem_t_max;
+
+  y_lo = y_lo > y_min ? y_lo : y_min;
+  y_hi = y_hi < y_max ? y_hi : y_max;
+
+  if (y_lo > y_hi)
+    return 0;
+
+  // The ends of the output's range are also where the saturated and
+  // activated values end up
+  const int64_t half = shift == 0 ? 0 : (int64_t)1 << (shift - 1);
+
+  if (y_lo == y_min)
+    sum->lo_unbounded = 1;
+  else
+    sum->lo += y_lo * ((int64_t)1 << shift) - half;
+
+  if (y_hi == y_max)
+    sum->hi_unbounded = 1;
+  else
+    sum->hi += y_hi * ((int64_t)1 << shift) + half;
+
+  return 1;
+}
+
+static int tiled_matmul_verify_sum_ok(const struct tiled_matmul_verify_sum_t * sum) {
+  return (sum->lo_unbounded || sum->lo <= sum->exact) &&
+    (sum->hi_unbounded || sum->exact <= sum->hi);
+}
+
+// The bias and fused residual of accumulator value (i, j)
+static int64_t tiled_matmul_verify_bias(size_t DIM_J, void * D,
+        const struct tiled_matmul_residual_t * fused, int shift, int full_bias_width,
+        size_t i, size_t j) {
+  int64_t result = tiled_matmul_residual_at(fused, shift, i, j);
+
+  if (D != NULL)
+    result += full_bias_width ? ((acc_t *)D)[i*DIM_J + j] : ((elem_t *)D)[i*DIM_J + j];
+
+  return result;
+}
+
+// Adds output y, at (i, j), to a sum. A residual which isn't fused is added to
+// the scaled down output, so it's taken back off first.
+static int tiled_matmul_verify_output(struct tiled_matmul_verify_sum_t * sum,
+        const struct tiled_matmul_residual_t * res, int unfused, elem_t y,
+        int act, int shift, int relu6_shift, size_t i, size_t j) {
+  int64_t y_lo = y, y_hi = y;
+
+  if (unfused && j < res->cols) {
+    const int64_t r = ROUNDING_RIGHT_SHIFT((acc_t)res->R[i*res->row_len + j], res->shift);
+    y_lo = y == elem_t_min ? INT64_MIN / 2 : y - r;
+    y_hi = y == elem_t_max ? INT64_MAX / 2 : y - r;
+  }
+
+  return tiled_matmul_verify_add(sum, y_lo, y_hi, act, shift, relu6_shift);
+}
+
+// Checks the sums of accumulator rows i0 to i0 + rows - 1, whose outputs are
+// Y's rows, from the row sums of B
+static int tiled_matmul_verify_rows(size_t DIM_J, size_t DIM_K,
+        elem_t A[][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * fused,
+        const struct tiled_matmul_residual_t * res, int unfused,
+        elem_t Y[][DIM_J], size_t i0, size_t rows,
+        int act, int shift, int relu6_shift, int full_bias_width) {
+  struct tiled_matmul_verify_sum_t * sums = tiled_matmul_verify_sums;
+  int64_t * k_sums = tiled_matmul_verify_k_sums;
+
+  for (size_t r0 = 0; r0 < rows; r0 += VERIFY_CHUNK) {
+    const size_t n = rows - r0 < VERIFY_CHUNK ? rows - r0 : VERIFY_CHUNK;
+
+    for (size_t r = 0; r < n; r++)
+      sums[r] = (struct tiled_matmul_verify_sum_t){0};
+
+    for (size_t k0 = 0; k0 < DIM_K; k0 += VERIFY_CHUNK) {
+      const size_t kc = DIM_K - k0 < VERIFY_CHUNK ? DIM_K - k0 : VERIFY_CHUNK;
+
+      // With only one chunk of K, B's row sums carry over between rows
+      if (r0 == 0 || DIM_K > VERIFY_CHUNK) {
+        for (size_t k = 0; k < kc; k++) {
+          k_sums[k] = 0;
+          for (size_t j = 0; j < DIM_J; j++)
+            k_sums[k] += B[k0 + k][j];
+        }
+      }
+
+      for (size_t r = 0; r < n; r++)
+        for (size_t k = 0; k < kc; k++)
+          sums[r].exact += A[i0 + r0 + r][k0 + k] * k_sums[k];
+    }
+
+    for (size_t r = 0; r < n; r++) {
+      const size_t i = i0 + r0 + r;
+
+      for (size_t j = 0; j < DIM_J; j++) {
+        sums[r].exact += tiled_matmul_verify_bias(DIM_J, D, fused, shift, full_bias_width, i, j);
+
+        if (!tiled_matmul_verify_output(&sums[r], res, unfused, Y[r0 + r][j],
+              act, shift, relu6_shift, i, j))
+          return 0;
+      }
+
+      if (!tiled_matmul_verify_sum_ok(&sums[r]))
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Checks the sums of every column of the accumulator, from the column sums of A
+static int tiled_matmul_verify_cols(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * fused,
+        const struct tiled_matmul_residual_t * res, int unfused,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width) {
+  struct tiled_matmul_verify_sum_t * sums = tiled_matmul_verify_sums;
+  int64_t * k_sums = tiled_matmul_verify_k_sums;
+
+  for (size_t j0 = 0; j0 < DIM_J; j0 += VERIFY_CHUNK) {
+    const size_t n = DIM_J - j0 < VERIFY_CHUNK ? DIM_J - j0 : VERIFY_CHUNK;
+
+    for (size_t c = 0; c < n; c++)
+      sums[c] = (struct tiled_matmul_verify_sum_t){0};
+
+    for (size_t k0 = 0; k0 < DIM_K; k0 += VERIFY_CHUNK) {
+      const size_t kc = DIM_K - k0 < VERIFY_CHUNK ? DIM_K - k0 : VERIFY_CHUNK;
+
+      if (j0 == 0 || DIM_K > VERIFY_CHUNK) {
+        for (size_t k = 0; k < kc; k++)
+          k_sums[k] = 0;
+        for (size_t i = 0; i < DIM_I; i++)
+          for (size_t k = 0; k < kc; k++)
+            k_sums[k] += A[i][k0 + k];
+      }
+
+      for (size_t k = 0; k < kc; k++)
+        for (size_t c = 0; c < n; c++)
+          sums[c].exact += k_sums[k] * B[k0 + k][j0 + c];
+    }
+
+    for (size_t i = 0; i < DIM_I; i++) {
+      for (size_t c = 0; c < n; c++) {
+        sums[c].exact += tiled_matmul_verify_bias(DIM_J, D, fused, shift,
+            full_bias_width, i, j0 + c);
+
+        if (!tiled_matmul_verify_output(&sums[c], res, unfused, C[i][j0 + c],
+              act, shift, relu6_shift, i, j0 + c))
+          return 0;
+      }
+    }
+
+    for (size_t c = 0; c < n; c++)
+      if (!tiled_matmul_verify_sum_ok(&sums[c]))
+        return 0;
+  }
+
+  return 1;
+}
+
+// Reruns accumulator rows i0 to i0 + rows - 1 on Gemmini with NO_ACTIVATION,
+// checks the rerun's sums, and returns whether C's rows are its activated
+// outputs
+static int tiled_matmul_verify_preact(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * fused,
+        const struct tiled_matmul_residual_t * res, int unfused,
+        elem_t C[DIM_I][DIM_J], size_t i0, size_t rows,
+        int act, int shift, int relu6_shift, int full_bias_width) {
+  elem_t (*Y)[DIM_J] = (elem_t (*)[DIM_J])tiled_matmul_verify_scratch;
+
+  void * D_rows = D == NULL ? NULL :
+    (char *)D + i0*DIM_J*(full_bias_width ? sizeof(acc_t) : sizeof(elem_t));
+
+  struct tiled_matmul_residual_t fused_rows;
+  if (fused != NULL) {
+    fused_rows = *fused;
+    fused_rows.R += i0*fused->row_len;
+  }
+
+  // A plan of its own, rather than a tuned one, so that verifying doesn't
+  // print tuning results
+  const struct tiled_matmul_plan_t plan = tiled_matmul_plan(rows, DIM_J, DIM_K,
+      D == NULL, full_bias_width, OS);
+  tiled_matmul_with_plan(rows, DIM_J, DIM_K, &A[i0], B, D_rows,
+      fused == NULL ? NULL : &fused_rows, Y,
+      NO_ACTIVATION, shift, relu6_shift, full_bias_width, &plan);
+
+  if (!tiled_matmul_verify_rows(DIM_J, DIM_K, A, B, D, fused, NULL, 0, Y, i0, rows,
+        NO_ACTIVATION, shift, relu6_shift, full_bias_width))
+    return 0;
+
+  const int64_t relu6_max = (int64_t)6 << relu6_shift;
+
+  for (size_t r = 0; r < rows; r++) {
+    const size_t i = i0 + r;
+
+    for (size_t j = 0; j < DIM_J; j++) {
+      int64_t y = Y[r][j] < 0 ? 0 : Y[r][j];
+      if (act == RELU6 && y > relu6_max)
+        y = relu6_max;
+
+      if (unfused && j < res->cols) {
+        y += ROUNDING_RIGHT_SHIFT((acc_t)res->R[i*res->row_len + j], res->shift);
+        y = y > elem_t_max ? elem_t_max : (y < elem_t_min ? elem_t_min : y);
+      }
+
+      if (C[i][j] != y)
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Recomputes tile (ti, tj) of C on the CPU, and returns whether it matches
+static int tiled_matmul_verify_tile(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res, int unfused,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        size_t ti, size_t tj) {
+  for (size_t i = ti*DIM; i < DIM_I && i < (ti+1)*DIM; i++) {
+    for (size_t j = tj*DIM; j < DIM_J && j < (tj+1)*DIM; j++) {
+      acc_t result = tiled_matmul_verify_bias(DIM_J, D, unfused ? NULL : res,
+          shift, full_bias_width, i, j);
+
+      for (size_t k = 0; k < DIM_K; k++)
+        result += A[i][k] * B[k][j];
+
+      elem_t gold = matmul_cpu_scale(result, act, shift, relu6_shift);
+
+      if (unfused && j < res->cols) {
+        const acc_t sum = ROUNDING_RIGHT_SHIFT((acc_t)res->R[i*res->row_len + j], res->shift) + gold;
+        gold = sum > elem_t_max ? elem_t_max : (sum < elem_t_min ? elem_t_min : sum);
+      }
+
+      if (C[i][j] != gold)
+        return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Returns whether C is consistent with the matmul's inputs
+static int __attribute__((unused)) tiled_matmul_verify(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width) {
+  const int unfused = res != NULL && !tiled_matmul_residual_fused(res, shift);
+  const struct tiled_matmul_residual_t * fused = unfused ? NULL : res;
+
+  if (!tiled_matmul_verify_rows(DIM_J, DIM_K, A, B, D, fused, res, unfused, C, 0, DIM_I,
+        act, shift, relu6_shift, full_bias_width))
+    return 0;
+
+  if (!tiled_matmul_verify_cols(DIM_I, DIM_J, DIM_K, A, B, D, fused, res, unfused, C,
+        act, shift, relu6_shift, full_bias_width))
+    return 0;
+
+  // The tiles, and the rows which are rerun, are drawn from an LCG of their
+  // own, seeded from the dimensions, so that verifying a layer doesn't advance
+  // the program's rand(), and always samples the same parts of it
+  uint64_t lcg = ((uint64_t)DIM_I << 42) ^ ((uint64_t)DIM_J << 21) ^ DIM_K;
+
+  // Rows rerun without activation
+  if (act != NO_ACTIVATION) {
+    size_t rows = VERIFY_SCRATCH_ELEMS / DIM_J;
+    rows = rows < VERIFY_SAMPLED_ROWS ? rows : VERIFY_SAMPLED_ROWS;
+    rows = rows < DIM_I ? rows : DIM_I;
+
+    lcg = lcg * 6364136223846793005ULL + 1442695040888963407ULL;
+    const size_t i0 = (lcg >> 33) % (DIM_I - rows + 1);
+
+    if (rows > 0 && !tiled_matmul_verify_preact(DIM_I, DIM_J, DIM_K, A, B, D,
+          fused, res, unfused, C, i0, rows, act, shift, relu6_shift, full_bias_width))
+      return 0;
+  }
+
+  // Sampled tiles
+  const size_t tiles_i = (DIM_I + DIM - 1) / DIM;
+  const size_t tiles_j = (DIM_J + DIM - 1) / DIM;
+  const size_t tiles = tiles_i * tiles_j;
+  const size_t sampled = tiles <= VERIFY_SAMPLED_TILES ? tiles : VERIFY_SAMPLED_TILES;
+
+  for (size_t t = 0; t < sampled; t++) {
+    lcg = lcg * 6364136223846793005ULL + 1442695040888963407ULL;
+    const size_t tile = tiles <= VERIFY_SAMPLED_TILES ? t : (lcg >> 33) % tiles;
+
+    if (!tiled_matmul_verify_tile(DIM_I, DIM_J, DIM_K, A, B, D, res, unfused, C,
+          act, shift, relu6_shift, full_bias_width, tile / tiles_j, tile % tiles_j))
+      return 0;
+  }
+
+  return 1;
+}
+
+// Like tiled_matmul_option, but C is written channel-major, as the NCHW
+// [DIM_I/pixels][DIM_J][pixels] tensor which the next layer of a network with
+// NCHW activations reads, so the output doesn't need a separate col2im pass
+static void __attribute__((unused)) tiled_matmul_option_nchw(size_t DIM_I,
+        size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        elem_t * C, size_t pixels,
+        int act, int shift, int relu6_shift, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+    const struct tiled_matmul_plan_t plan = tiled_matmul_plan_tuned(DIM_I, DIM_J,
+            DIM_K, D == NULL, act, full_bias_width, tiled_matmul_type);
+
+    if (plan.dataflow == OS || plan.dataflow == WS) {
+        tiled_matmul_conv(DIM_I, DIM_J, DIM_K, A, B, D, (elem_t (*)[DIM_J])C,
+                plan.tile_i, plan.tile_j, plan.tile_k, plan.loop_order,
+                tiled_matmul_plan_dataflow(&plan), NULL, pixels, NULL,
+                act, shift, relu6_shift, full_bias_width);
+    } else {
+        matmul_cpu_pixels(DIM_I, DIM_J, DIM_K, A, B, D, NULL, C, pixels,
+                act, shift, relu6_shift, full_bias_width);
+    }
+}
+
+// A convolution of an NHWC input with HWIO weights, run as an implicit GEMM
+// on Gemmini. The patch matrix, with one row per output pixel and
+// kernel_dim*kernel_dim*in_channels columns, is gathered from the input while
+// it's being moved in, rather than being materialized with im2col first. The
+// weights are the B matrix, the bias, residual and output are
+// batch*out_dim*out_dim x out_channels matrices, and everything else behaves
+// as in tiled_matmul_residual.
+static void __attribute__((unused)) tiled_conv_residual(size_t batch_size, size_t in_dim,
+        size_t in_channels, size_t out_channels, size_t out_dim,
+        size_t stride, size_t padding, size_t kernel_dim,
+        elem_t input[batch_size][in_dim][in_dim][in_channels],
+        elem_t weights[kernel_dim*kernel_dim*in_channels][out_channels],
+        void * bias, const struct tiled_matmul_residual_t * res,
+        elem_t output[batch_size*out_dim*out_dim][out_channels],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+    const size_t DIM_I = batch_size * out_dim * out_dim;
+    const size_t DIM_J = out_channels;
+    const size_t DIM_K = kernel_dim * kernel_dim * in_channels;
+
+    // The patch matrix of a pointwise conv with a stride of 1 is the input
+    // itself, so it's moved in directly, as a plain A matrix. Strided
+    // pointwise convs go through the implicit GEMM below, where every image
+    // row's worth of patch rows is already a single strided mvin, since a 1x1
+    // kernel never reads the padding or spans two kernel rows.
+    if (kernel_dim == 1 && stride == 1 && padding == 0) {
+        tiled_matmul_residual(DIM_I, DIM_J, DIM_K,
+                (elem_t (*)[DIM_K])&input[0][0][0][0], weights, bias, res, output,
+                act, shift, relu6_shift, full_bias_width, tiled_matmul_type);
+        return;
+    }
+
+    const struct tiled_conv_t conv = {
+        .input = &input[0][0][0][0], .batch_size = batch_size,
+        .in_dim = in_dim, .in_channels = in_channels,
+        .in_pixel_len = in_channels, .out_dim = out_dim,
+        .stride = stride, .padding = padding, .kernel_dim = kernel_dim,
+    };
+
+    const struct tiled_matmul_plan_t plan = tiled_matmul_plan_tuned(DIM_I, DIM_J,
+            DIM_K, bias == NULL, act, full_bias_width, tiled_matmul_type);
+
+    const struct tiled_matmul_residual_t * fused =
+        tiled_matmul_residual_fused(res, shift) ? res : NULL;
+
+    if (plan.dataflow == OS || plan.dataflow == WS) {
+        tiled_matmul_conv(DIM_I, DIM_J, DIM_K, NULL, weights, bias, output,
+                plan.tile_i, plan.tile_j, plan.tile_k, plan.loop_order,
+                tiled_matmul_plan_dataflow(&plan), &conv, 0, fused,
+                act, shift, relu6_shift, full_bias_width);
+    } else {
+        conv_cpu(batch_size, in_dim, in_channels, out_channels, out_dim,
+                stride, padding, kernel_dim, input, weights, bias, fused, output,
+                act, shift, relu6_shift, full_bias_width);
+    }
+
+    if (res != NULL && fused == NULL)
+        matmul_cpu_add_residual(DIM_I, DIM_J, res, output);
+}
+
+static void __attribute__((unused)) tiled_conv(size_t batch_size, size_t in_dim,
+        size_t in_channels, size_t out_channels, size_t out_dim,
+        size_t stride, size_t padding, size_t kernel_dim,
+        elem_t input[batch_size][in_dim][in_dim][in_channels],
+        elem_t weights[kernel_dim*kernel_dim*in_channels][out_channels],
+        void * bias, elem_t output[batch_size*out_dim*out_dim][out_channels],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+    tiled_conv_residual(batch_size, in_dim, in_channels, out_channels, out_dim,
+            stride, padding, kernel_dim, input, weights, bias, NULL, output,
+            act, shift, relu6_shift, full_bias_width, tiled_matmul_type);
+}
+
+// Winograd F(2x2, 3x3) convolutions, for 3x3 convs with a stride of 1 and a
+// padding of 1. Each 2x2 block of output pixels is computed from a 4x4 tile of
+// the input, as Y = A^T [U . V] A, where U = G g G^T are the transformed
+// weights, V = B^T d B is the transformed input tile, and the 16 element-wise
+// products, summed over the input channels, are 16 matmuls. That's 16 MACs
+// per 2x2 output block and input channel, rather than 36.
+//
+// The transforms are integer: the weights are transformed with 2G, so U is 4
+// times larger than it should be, and the input's transform has 10 bit
+// results, so V is rounded down by a shift of up to 3 bits to fit in an
+// elem_t. The 16 products are moved out of the accumulator as elem_t's, with
+// WINOGRAD_HEADROOM_BITS fewer bits of shift than the output, and the output
+// transform sums them on the CPU. A product which saturates is rerun with one
+// more bit of shift. So unlike every other conv, the output isn't exact, and
+// networks should check it with winograd_within_tolerance before using it.
+#ifndef WINOGRAD_BUFFER_ELEMS
+#define WINOGRAD_BUFFER_ELEMS (1 << 18)
+#endif
+
+#define WINOGRAD_HEADROOM_BITS 2
+#define WINOGRAD_MAX_RETRIES 8
+
+// The largest mean absolute error of a Winograd conv's output
+#define WINOGRAD_TOLERANCE 2
+
+static elem_t winograd_V[WINOGRAD_BUFFER_ELEMS] row_align(1);
+static elem_t winograd_M[WINOGRAD_BUFFER_ELEMS] row_align(1);
+
+// Transforms HWIO 3x3 weights, with the same layout as tiled_conv's, into
+// U[16][in_channels][out_channels]. Returns whether every transformed weight
+// fits in an elem_t. If they don't, the conv has to be run exactly instead.
+static int __attribute__((unused)) winograd_transform_weights(size_t in_channels,
+        size_t out_channels, elem_t weights[9*in_channels][out_channels],
+        elem_t U[16][in_channels][out_channels]) {
+  static const int G[4][3] = {{2, 0, 0}, {1, 1, 1}, {1, -1, 1}, {0, 0, 2}};
+  int fits = 1;
+
+  for (size_t c = 0; c < in_channels; c++) {
+    for (size_t oc = 0; oc < out_channels; oc++) {
+      acc_t Gg[4][3];
+      for (size_t i = 0; i < 4; i++)
+        for (size_t kw = 0; kw < 3; kw++) {
+          Gg[i][kw] = 0;
+          for (size_t kh = 0; kh < 3; kh++)
+            Gg[i][kw] += G[i][kh] * weights[(kh*3 + kw)*in_channels + c][oc];
+        }
+
+      for (size_t i = 0; i < 4; i++)
+        for (size_t j = 0; j < 4; j++) {
+          acc_t u = 0;
+          for (size_t kw = 0; kw < 3; kw++)
+            u += Gg[i][kw] * G[j][kw];
+
+          fits = fits && u >= elem_t_min && u <= elem_t_max;
+          U[i*4 + j][c][oc] = u;
+        }
+    }
+  }
+
+  return fits;
+}
+
+static int __attribute__((unused)) winograd_within_tolerance(size_t n,
+        const elem_t * output, const elem_t * exact) {
+  size_t error = 0;
+  for (size_t i = 0; i < n; i++)
+    error += output[i] > exact[i] ? output[i] - exact[i] : exact[i] - output[i];
+  return error <= WINOGRAD_TOLERANCE * n;
+}
+
+struct winograd_args_t {
+  size_t dim, tiles_dim, in_channels, out_channels;
+  size_t tile_start, chunk_tiles;
+  const elem_t * input;
+  const acc_t * bias;
+  elem_t * output;
+  int v_shift, e, act, shift, relu6_shift;
+  int t0, t[16];
+};
+
+static void winograd_input_tiles(void * args, size_t begin, size_t end) {
+  const struct winograd_args_t * const a = args;
+  const size_t dim = a->dim, C = a->in_channels;
+  const size_t pos_len = a->chunk_tiles * C;
+
+  for (size_t t = begin; t < end; t++) {
+    const size_t tile = a->tile_start + t;
+    const size_t n = tile / (a->tiles_dim * a->tiles_dim);
+    const int th = 2*((tile / a->tiles_dim) % a->tiles_dim) - 1;
+    const int tw = 2*(tile % a->tiles_dim) - 1;
+
+    for (size_t c = 0; c < C; c++) {
+      acc_t d[4][4];
+      for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) {
+          const int ih = th + i, iw = tw + j;
+          d[i][j] = ih < 0 || ih >= (int)dim || iw < 0 || iw >= (int)dim ? 0 :
+            a->input[((n*dim + ih)*dim + iw)*C + c];
+        }
+
+      // B^T d, then (B^T d) B
+      acc_t Bd[4][4];
+      for (int j = 0; j < 4; j++) {
+        Bd[0][j] = d[0][j] - d[2][j];
+        Bd[1][j] = d[1][j] + d[2][j];
+        Bd[2][j] = d[2][j] - d[1][j];
+        Bd[3][j] = d[1][j] - d[3][j];
+      }
+
+      for (int i = 0; i < 4; i++) {
+        const acc_t v[4] = {
+          Bd[i][0] - Bd[i][2], Bd[i][1] + Bd[i][2],
+          Bd[i][2] - Bd[i][1], Bd[i][1] - Bd[i][3],
+        };
+
+        for (int j = 0; j < 4; j++) {
+          acc_t r = ROUNDING_RIGHT_SHIFT(v[j], a->v_shift);
+          r = r > elem_t_max ? elem_t_max : (r < elem_t_min ? elem_t_min : r);
+          winograd_V[(i*4 + j)*pos_len + t*C + c] = r;
+        }
+      }
+    }
+  }
+}
+
+static void winograd_output_tiles(void * args, size_t begin, size_t end) {
+  const struct winograd_args_t * const a = args;
+  const size_t dim = a->dim, OC = a->out_channels;
+  const size_t pos_len = a->chunk_tiles * OC;
+
+  for (size_t t = begin; t < end; t++) {
+    const size_t tile = a->tile_start + t;
+    const size_t n = tile / (a->tiles_dim * a->tiles_dim);
+    const size_t oh = 2*((tile / a->tiles_dim) % a->tiles_dim);
+    const size_t ow = 2*(tile % a->tiles_dim);
+
+    for (size_t oc = 0; oc < OC; oc++) {
+      acc_t m[4][4];
+      for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+          m[i][j] = winograd_M[(i*4 + j)*pos_len + t*OC + oc] *
+            (1 << (a->t[i*4 + j] - a->t0));
+
+      // A^T m, then (A^T m) A
+      acc_t Am[2][4];
+      for (int j = 0; j < 4; j++) {
+        Am[0][j] = m[0][j] + m[1][j] + m[2][j];
+        Am[1][j] = m[1][j] - m[2][j] - m[3][j];
+      }
+
+      const acc_t bias = a->bias == NULL ? 0 : a->bias[oc];
+
+      for (int i = 0; i < 2 && oh + i < dim; i++) {
+        const acc_t y[2] = {
+          Am[i][0] + Am[i][1] + Am[i][2], Am[i][1] - Am[i][2] - Am[i][3],
+        };
+
+        for (int j = 0; j < 2 && ow + j < dim; j++) {
+          // The products were scaled down by e fewer bits than the output
+          const acc_t result = a->e >= 0 ?
+            y[j] * (1 << a->e) + bias : y[j] + bias * (1 << -a->e);
+          const int shift = a->e >= 0 ? a->shift : a->shift - a->e;
+
+          a->output[((n*dim + oh + i)*dim + ow + j)*OC + oc] =
+            matmul_cpu_scale(result, a->act, shift, a->relu6_shift);
+        }
+      }
+    }
+  }
+}
+
+// A 3x3 conv with a stride of 1 and a padding of 1, of an NHWC input, using
+// the weights transformed by winograd_transform_weights. The output is a
+// batch*dim*dim x out_channels matrix, like tiled_conv's, and the bias is an
+// optional full-width bias per channel. The tiles are transformed a chunk at
+// a time, sized to fit in WINOGRAD_BUFFER_ELEMS, and each chunk's 16 products
+// are run as matmuls with the given option. Returns whether the buffers were
+// large enough for the conv's channels. If they weren't, the output is left
+// untouched, and the conv has to be run exactly instead.
+static int __attribute__((unused)) tiled_conv_winograd(size_t batch_size,
+        size_t dim, size_t in_channels, size_t out_channels,
+        elem_t input[batch_size][dim][dim][in_channels],
+        elem_t U[16][in_channels][out_channels], acc_t * bias,
+        elem_t output[batch_size*dim*dim][out_channels],
+        int act, int shift, int relu6_shift,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+  const size_t tiles_dim = (dim + 1) / 2;
+  const size_t tiles = batch_size * tiles_dim * tiles_dim;
+  const size_t max_channels = in_channels > out_channels ? in_channels : out_channels;
+
+  size_t chunk_tiles = WINOGRAD_BUFFER_ELEMS / (16 * max_channels);
+  if (chunk_tiles > DIM)
+    chunk_tiles -= chunk_tiles % DIM;
+  if (chunk_tiles == 0)
+    return 0;
+
+  // V is shifted just enough for the largest input's transform to fit
+  acc_t max_input = 0;
+  for (size_t i = 0; i < batch_size*dim*dim*in_channels; i++) {
+    const acc_t x = (&input[0][0][0][0])[i];
+    max_input = x > max_input ? x : (-x > max_input ? -x : max_input);
+  }
+
+  int v_shift = 0;
+  while (ROUNDING_RIGHT_SHIFT(4*max_input, v_shift) > elem_t_max)
+    v_shift++;
+
+  // U is 4 times too large, so the products have 2 bits more than the
+  // output's accumulator, minus the bits V was shifted by
+  int t = shift - WINOGRAD_HEADROOM_BITS + 2 - v_shift;
+  t = t < 0 ? 0 : t;
+
+  struct winograd_args_t args = {
+    .dim = dim, .tiles_dim = tiles_dim,
+    .in_channels = in_channels, .out_channels = out_channels,
+    .input = &input[0][0][0][0], .bias = bias, .output = &output[0][0],
+    .v_shift = v_shift, .e = t + v_shift - 2, .t0 = t,
+    .act = act, .shift = shift, .relu6_shift = relu6_shift,
+  };
+
+  for (size_t pos = 0; pos < 16; pos++)
+    args.t[pos] = t;
+
+  for (size_t t0 = 0; t0 < tiles; t0 += chunk_tiles) {
+    const size_t I = tiles - t0 < chunk_tiles ? tiles - t0 : chunk_tiles;
+    args.tile_start = t0;
+    args.chunk_tiles = I;
+
+    cpu_parallel_for(I, winograd_input_tiles, &args);
+
+    for (size_t pos = 0; pos < 16; pos++) {
+      elem_t * const M = winograd_M + pos*I*out_channels;
+
+      // The larger shift is kept for the rest of the chunks
+      for (;;) {
+        tiled_matmul_option(I, out_channels, in_channels,
+            (elem_t (*)[in_channels])(winograd_V + pos*I*in_channels), U[pos], NULL,
+            (elem_t (*)[out_channels])M,
+            NO_ACTIVATION, args.t[pos], 0, 0, tiled_matmul_type);
+
+        int saturated = 0;
+        for (size_t i = 0; i < I*out_channels && !saturated; i++)
+          saturated = M[i] == elem_t_max || M[i] == elem_t_min;
+
+        if (!saturated || args.t[pos] - t >= WINOGRAD_MAX_RETRIES)
+          break;
+        args.t[pos]++;
+      }
+    }
+
+    cpu_parallel_for(I, winograd_output_tiles, &args);
+  }
+
+  return 1;
+}
+
+// Depthwise convs are run on Gemmini one block of DIM channels at a time. The
+// weights of each kernel position are expanded into a diagonal DIM x DIM
+// matrix, so the block is an implicit GEMM whose K dimension is the kernel
+// positions, and whose patch columns are only DIM channels of one kernel
+// position each. The diagonal weights are built by the CPU into one of these
+// two buffers, while the previous channel block is being computed.
+#ifndef CONV_DW_MAX_KERNEL_DIM
+#define CONV_DW_MAX_KERNEL_DIM 5
+#endif
+
+static elem_t tiled_conv_dw_diag[2][CONV_DW_MAX_KERNEL_DIM*CONV_DW_MAX_KERNEL_DIM*DIM][DIM] row_align(1);
+
+static void tiled_conv_dw_build_diag(size_t channels, size_t kernel_dim,
+        elem_t weights[channels][kernel_dim][kernel_dim],
+        size_t c0, size_t cols, elem_t diag[][DIM]) {
+  for (size_t kpos = 0; kpos < kernel_dim*kernel_dim; kpos++) {
+    for (size_t r = 0; r < DIM; r++) {
+      for (size_t c = 0; c < DIM; c++)
+        diag[kpos*DIM + r][c] = 0;
+
+      if (r < cols)
+        diag[kpos*DIM + r][r] = weights[c0 + r][kpos / kernel_dim][kpos % kernel_dim];
+    }
+  }
+}
+
+// Returns whether a depthwise conv is expected to run faster on Gemmini than
+// on the CPU. Only one in DIM of the array's MACs is useful, every input
+// pixel is moved in once per kernel position, and every kernel position's
+// weights are preloaded once per block of output pixels, so small layers can
+// be faster on the CPU.
+static int tiled_conv_dw_on_gemmini(size_t pixels, size_t channels,
+        size_t kernel_dim, size_t tile_pixels) {
+  const size_t taps = kernel_dim * kernel_dim;
+  const size_t I_blocks = (pixels + DIM - 1) / DIM;
+  const size_t C_blocks = (channels + DIM - 1) / DIM;
+  const size_t tiles = (pixels + tile_pixels - 1) / tile_pixels;
+
+  const size_t cpu_cycles = pixels * channels * taps * CPU_CYCLES_PER_MAC /
+    cpu_parallel_workers();
+
+  const size_t array_cycles = (I_blocks + tiles) * C_blocks * taps * DIM;
+  const size_t mem_bytes = pixels * channels * (taps + 1) * sizeof(elem_t) +
+    C_blocks * taps * DIM * DIM * sizeof(elem_t);
+  const size_t mem_cycles = mem_bytes / GEMMINI_BYTES_PER_CYCLE;
+
+  const size_t gemmini_cycles = (array_cycles > mem_cycles ? array_cycles : mem_cycles) +
+    GEMMINI_CALL_CYCLES;
+
+  return gemmini_cycles < cpu_cycles;
+}
+
+// A depthwise convolution of an NHWC input, with one kernel_dim x kernel_dim
+// kernel per channel and an optional full-width bias per channel. The output
+// is a batch*out_dim*out_dim x channels matrix, so it's NHWC as well.
+//
+// On Gemmini, each channel block is computed a tile of output pixels at a
+// time, weight-stationary. Every kernel position's diagonal weights are
+// preloaded once per tile, and the tile's pixel blocks are streamed through
+// the array, accumulating into the same output rows. The patch blocks are
+// moved in like tiled_conv's, as strided mvins of the block's channels. The
+// bias is broadcast into the accumulator by a mvin with a stride of 0. Tiles
+// alternate between the two halves of the accumulator, so one tile is moved
+// out while the next is computed.
+//
+// OS and WS both run on Gemmini, CPU runs on the CPU, and AUTO picks whichever
+// the cost model above expects to be faster.
+static void __attribute__((unused)) tiled_conv_dw(size_t batch_size,
+        size_t in_dim, size_t channels, size_t out_dim,
+        size_t stride, size_t padding, size_t kernel_dim,
+        elem_t input[batch_size][in_dim][in_dim][channels],
+        elem_t weights[channels][kernel_dim][kernel_dim],
+        acc_t * bias, elem_t output[batch_size*out_dim*out_dim][channels],
+        int act, int shift, int relu6_shift,
+        enum tiled_matmul_type_t tiled_matmul_type) {
+  const size_t pixels = batch_size * out_dim * out_dim;
+  const size_t taps = kernel_dim * kernel_dim;
+  const size_t TILE_I = ACC_BUFFER_ROWS / DIM;
+  const size_t A_ring_blocks = SP_PARTITION_ROWS / DIM;
+
+  const int on_cpu = tiled_matmul_type == CPU ||
+    kernel_dim > CONV_DW_MAX_KERNEL_DIM ||
+    (tiled_matmul_type == AUTO &&
+     !tiled_conv_dw_on_gemmini(pixels, channels, kernel_dim, TILE_I*DIM));
+
+  if (on_cpu) {
+    conv_dw_cpu(batch_size, in_dim, channels, out_dim, stride, padding,
+        kernel_dim, input, weights, bias, output, act, shift, relu6_shift);
+    return;
+  }
+
+  const size_t I_blocks = (pixels + DIM - 1) / DIM;
+  const size_t C_blocks = (channels + DIM - 1) / DIM;
+  const size_t I0 = (I_blocks + TILE_I - 1) / TILE_I;
+
+  matmul_config_ex(WEIGHT_STATIONARY, act, 0, shift, relu6_shift);
+  matmul_config_st(channels * sizeof(elem_t));
+
+  tiled_conv_dw_build_diag(channels, kernel_dim, weights, 0,
+      channels < DIM ? channels : DIM, tiled_conv_dw_diag[0]);
+
+  size_t A_block = 0;
+  int acc_buf = 0;
+
+  for (size_t cb = 0; cb < C_blocks; cb++) {
+    const size_t c0 = cb * DIM;
+    const size_t cols = channels - c0 < DIM ? channels - c0 : DIM;
+    const int diag_buf = cb % 2;
+
+    const struct tiled_conv_t conv = {
+      .input = &input[0][0][0][c0], .batch_size = batch_size,
+      .in_dim = in_dim, .in_channels = cols, .in_pixel_len = channels,
+      .out_dim = out_dim, .stride = stride, .padding = padding,
+      .kernel_dim = kernel_dim,
+    };
+
+    const uint32_t B_sp_addr_start = B_SP_ADDR_START + diag_buf*taps*DIM;
+
+    matmul_config_ld(DIM * sizeof(elem_t));
+    for (size_t kpos = 0; kpos < taps; kpos++)
+      matmul_extended_mvin(tiled_conv_dw_diag[diag_buf][kpos*DIM],
+          B_sp_addr_start + kpos*DIM, cols, cols);
+
+    for (size_t i0 = 0; i0 < I0; i0++) {
+      const size_t I = i0 < I0-1 ? TILE_I : I_blocks - i0*TILE_I;
+      const uint32_t acc_addr = acc_buf * ACC_BUFFER_ROWS;
+      acc_buf = !acc_buf;
+
+      if (bias != NULL) {
+        matmul_config_ld(0);
+
+        for (size_t i = 0; i < I; i++) {
+          const size_t p = (i0*TILE_I + i) * DIM;
+          const size_t rows = pixels - p < DIM ? pixels - p : DIM;
+          matmul_extended_mvin(bias + c0, (1 << (ADDR_LEN-1)) | (acc_addr + i*DIM),
+              cols, rows);
+        }
+      }
+
+      for (size_t kpos = 0; kpos < taps; kpos++) {
+        const uint32_t B_sp_addr = B_sp_addr_start + kpos*DIM;
+
+        for (size_t i = 0; i < I; i++) {
+          const size_t p = (i0*TILE_I + i) * DIM;
+          const size_t rows = pixels - p < DIM ? pixels - p : DIM;
+          const uint32_t A_sp_addr = A_SP_ADDR_START + A_block*DIM;
+          A_block = (A_block + 1) % A_ring_blocks;
+
+          sp_tiled_conv_mvin(&conv, p, kpos*cols, A_sp_addr, cols, rows);
+
+          // Without a bias, the first kernel position overwrites what's in
+          // the accumulator, rather than accumulating onto it
+          uint32_t out_sp_addr = (3 << (ADDR_LEN-2)) | (acc_addr + i*DIM);
+          if (bias == NULL && kpos == 0)
+            out_sp_addr &= ~(1 << (ADDR_LEN-2));
+
+          matmul_extended_preload(i == 0 ? B_sp_addr : GARBAGE_ADDR, out_sp_addr,
+              cols, cols, cols, rows);
+
+          if (i == 0) {
+            matmul_extended_compute_preloaded(A_sp_addr, GARBAGE_ADDR, cols, rows, DIM, DIM);
+          } else {
+            matmul_extended_compute_accumulated(A_sp_addr, GARBAGE_ADDR, cols, rows, DIM, DIM);
+          }
+        }
+      }
+
+      for (size_t i = 0; i < I; i++) {
+        const size_t p = (i0*TILE_I + i) * DIM;
+        const size_t rows = pixels - p < DIM ? pixels - p : DIM;
+        matmul_extended_mvout(&output[p][c0], (3 << (ADDR_LEN-2)) | (acc_addr + i*DIM),
+            cols, rows);
+      }
+    }
+
+    // The next block's diagonal weights go into the other buffer, whose
+    // mvins were all finished by the previous fence
+    if (cb + 1 < C_blocks) {
+      const size_t next_c0 = c0 + DIM;
+      tiled_conv_dw_build_diag(channels, kernel_dim, weights, next_c0,
+          channels - next_c0 < DIM ? channels - next_c0 : DIM,
+          tiled_conv_dw_diag[!diag_buf]);
+    }
+
+    matmul_fence();
+  }
+}
+
+// Global average pooling. The mean of P pixels is computed as a matmul of a
+// row of P copies of m with the pixels, scaled down by a shift of s bits,
+// where m / 2^s is the closest fraction to 1/P whose m fits in an elem_t. The
+// sums stay in the accumulator until they're scaled down, and the result is
+// the exact mean whenever P is a power of 2.
+static void tiled_global_avg_pool_scale(size_t pixels, elem_t * m, int * s) {
+  *s = 0;
+  while ((((acc_t)2 << *s) + pixels/2) / pixels <= elem_t_max)
+    (*s)++;
+  *m = (((acc_t)1 << *s) + pixels/2) / pixels;
+}
+
+struct global_avg_pool_args_t {
+  size_t batch_size, pixels, channels, out_pixels;
+  const elem_t * input;
+  elem_t * output;
+  elem_t m;
+  int s;
+};
+
+static void global_avg_pool_cpu_channels(void * args, size_t begin, size_t end) {
+  const struct global_avg_pool_args_t * a = args;
+
+  for (size_t b = 0; b < a->batch_size; b++) {
+    const elem_t * in = a->input + b*a->pixels*a->channels;
+
+    for (size_t c = begin; c < end; c++) {
+      acc_t sum = 0;
+      for (size_t p = 0; p < a->pixels; p++)
+        sum += in[p*a->channels + c];
+
+      const size_t o = a->out_pixels == 0 ? b*a->channels + c : c*a->out_pixels + b;
+      a->output[o] = matmul_cpu_scale(sum * a->m, NO_ACTIVATION, a->s, 0);
+    }
+  }
+}
+
+// Gemmini pools one image at a time, as a matmul of a single row of m's with
+// the image's pixels, so the row is built once, in this buffer. Images with
+// more pixels than it holds are pooled on the CPU.
+#ifndef GLOBAL_AVG_POOL_MAX_PIXELS
+#define GLOBAL_AVG_POOL_MAX_PIXELS 1024
+#endif
+
+static elem_t tiled_global_avg_pool_row[GLOBAL_AVG_POOL_MAX_PIXELS] row_align(1);
+
+// Averages each image of a batch of NHWC images, input[batch_size*pixels]
+// [channels], over all of its pixels. If out_pixels is 0, the output is a
+// batch_size x channels matrix. Otherwise, it's written channel-major, as the
+// channels x out_pixels B matrix of the fully-connected layer which follows
+// the pool, and its columns past batch_size are zeroed.
+//
+// OS and WS run the pool on Gemmini. CPU splits the channels over the cores,
+// and AUTO picks Gemmini, since the pool is a single pass over its input
+// either way.
+static void __attribute__((unused)) tiled_global_avg_pool(size_t batch_size,
+        size_t pixels, size_t channels, const elem_t * input, elem_t * output,
+        size_t out_pixels, enum tiled_matmul_type_t tiled_matmul_type) {
+  struct global_avg_pool_args_t args = {
+    .batch_size = batch_size, .pixels = pixels, .channels = channels,
+    .out_pixels = out_pixels, .input = input, .output = output,
+  };
+  tiled_global_avg_pool_scale(pixels, &args.m, &args.s);
+
+  if (out_pixels != 0) {
+    for (size_t c = 0; c < channels; c++)
+      for (size_t b = batch_size; b < out_pixels; b++)
+        output[c*out_pixels + b] = 0;
+  }
+
+  if (tiled_matmul_type == CPU || pixels > GLOBAL_AVG_POOL_MAX_PIXELS) {
+    cpu_parallel_for(channels, global_avg_pool_cpu_channels, &args);
+    return;
+  }
+
+  for (size_t p = 0; p < pixels; p++)
+    tiled_global_avg_pool_row[p] = args.m;
+
+  // A channel-major output with a single row is one column of the output
+  for (size_t b = 0; b < batch_size; b++) {
+    elem_t * const out = out_pixels == 0 ? output + b*channels : output + b;
+
+    tiled_matmul_option_nchw(1, channels, pixels,
+            (elem_t (*)[pixels])tiled_global_avg_pool_row,
+            (elem_t (*)[channels])(input + b*pixels*channels), NULL, out, out_pixels,
+            NO_ACTIVATION, args.s, 0, 0, tiled_matmul_type == AUTO ? OS : tiled_matmul_type);
+  }
 }
 
 #endif  // SRC_MAIN_C_GEMMINI_H
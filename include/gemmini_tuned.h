@@ -0,0 +1,27 @@
+#ifndef GEMMINI_TUNED_H
+#define GEMMINI_TUNED_H
+
+// Tile sizes and dataflows measured to be fastest for specific matmuls.
+//
+// To regenerate this table, build a workload with -DGEMMINI_TUNE (e.g.
+// "make resnet50-16-tune") and run it on the target system. Every call to
+// tiled_matmul_option then prints an entry for this table. Matmuls which
+// aren't listed here fall back to tiled_matmul_plan.
+//
+// Entries are {I, J, K, act, full_bias_width, tile_i, tile_j, tile_k, dataflow,
+// loop_order}
+// Entries whose dataflow is CPU are only used by AUTO mode. Entries whose
+// tiles don't fit the scratchpad and accumulator are ignored.
+//
+// The table ends with an all-zero sentinel, which isn't an entry, so that it
+// is never empty. Paste new entries above it.
+
+static const struct tiled_matmul_tuned_t tiled_matmul_tuned[] = {
+  {0},
+};
+
+#define TILED_MATMUL_TUNED_ENTRIES \
+  (sizeof(tiled_matmul_tuned) / sizeof(tiled_matmul_tuned[0]) - 1)
+
+#endif  // GEMMINI_TUNED_H
+
@@ -5,14 +5,13 @@
 #define LEN(arr) ((int) (sizeof (arr) / sizeof (arr[0])))
 
 // batch size: 16
-// before zeropad: 100x140x20x50x10
-// after zeropad: 112x144x32x64x16
-elem_t input_mat[16][112] row_align(1)= {0};
-elem_t weights0[112][144] row_align(1)= {0};
-elem_t inter_results0[16][144] row_align(1)= {0};
-elem_t weights1[144][32] row_align(1)= {0};
-elem_t inter_results1[16][32] row_align(1)= {0};
-elem_t weights2[32][64] row_align(1)= {0};
-elem_t inter_results2[16][64] row_align(1)= {0};
-elem_t weights3[64][16] row_align(1)= {0};
-elem_t inter_results3[16][16] row_align(1)= {0};
+// layers: 100x140x20x50x10
+elem_t input_mat[16][100] row_align(1)= {0};
+elem_t weights0[100][140] row_align(1)= {0};
+elem_t inter_results0[16][140] row_align(1)= {0};
+elem_t weights1[140][20] row_align(1)= {0};
+elem_t inter_results1[16][20] row_align(1)= {0};
+elem_t weights2[20][50] row_align(1)= {0};
+elem_t inter_results2[16][50] row_align(1)= {0};
+elem_t weights3[50][10] row_align(1)= {0};
+elem_t inter_results3[16][10] row_align(1)= {0};
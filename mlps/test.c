@@ -11,31 +11,22 @@
 
 static void tiled_matmul_compare(size_t DIM_I, size_t DIM_J, size_t DIM_K,
         elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], acc_t D[DIM_I][DIM_J],
-        elem_t C[DIM_I][DIM_J], int act, int shift, int relu6_shift, int full_bias_width,
+        elem_t C[DIM_I][DIM_J], int no_bias, int act, int shift, int relu6_shift,
         enum tiled_matmul_type_t tiled_matmul_type,
         bool compare, char * layer_name)
 {
     if (compare)
         printf("%s: gemmini\n", layer_name);
     tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-        A, B, D, C, act, shift, relu6_shift, full_bias_width,
+        A, B, no_bias ? NULL : D, C, act, shift, relu6_shift, 1,
         tiled_matmul_type);
 
     if (compare) {
-        printf("%s: CPU\n", layer_name);
-        elem_t gold[DIM_I][DIM_J];
-        tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-            A, B, D, gold, act, shift, relu6_shift, full_bias_width,
-            CPU);
-
-        printf("%s: comparing\n", layer_name);
-        for (size_t i = 0; i < DIM_I; i++) {
-            for (size_t j = 0; j < DIM_J; j++) {
-                if (C[i][j] != gold[i][j]) {
-                    printf("Layer calculated incorrectly: %s\n", layer_name);
-                    exit(1);
-                }
-            }
+        printf("%s: verifying\n", layer_name);
+        if (!tiled_matmul_verify(DIM_I, DIM_J, DIM_K,
+                A, B, no_bias ? NULL : D, NULL, C, act, shift, relu6_shift, 1)) {
+            printf("Layer calculated incorrectly: %s\n", layer_name);
+            exit(1);
         }
     }
 }
@@ -52,7 +43,7 @@ int main (int argc, char * argv[]) {
 
     enum tiled_matmul_type_t tiled_matmul_type;
     if (argc < 2) {
-        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', or cpu'\n");
+        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', 'cpu', 'auto', or 'hybrid'\n");
         // exit(0);
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "cpu") == 0) {
@@ -61,6 +52,10 @@ int main (int argc, char * argv[]) {
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "ws") == 0) {
         tiled_matmul_type = WS;
+    } else if (strcmp(argv[1], "auto") == 0) {
+        tiled_matmul_type = AUTO;
+    } else if (strcmp(argv[1], "hybrid") == 0) {
+        tiled_matmul_type = HYBRID;
     }
 
     bool compare;
@@ -80,9 +75,9 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 0 */
 
-    tiled_matmul_compare(16, 112, 144,    // dimensions
+    tiled_matmul_compare(16, 140, 100,    // dimensions
     input_mat, weights0, NULL, inter_results0,      // addresses
-    RELU, 0, 0, 0,           // act, shift, r6_shift
+    1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_0");
     // verbose(0,input_mat,weights0,inter_results0)
     /* end of matmul number: 0 */
@@ -94,9 +89,9 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 1 */
 
-    tiled_matmul_compare(16, 144, 32,    // dimensions
+    tiled_matmul_compare(16, 20, 140,    // dimensions
     inter_results0, weights1, NULL, inter_results1,      // addresses
-    RELU, 0, 0, 0,           // act, shift, r6_shift
+    1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_1");
     // verbose(1,inter_results0,weights1,inter_results1)
     /* end of matmul number: 1 */
@@ -108,9 +103,9 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 2 */
 
-    tiled_matmul_compare(16, 32, 64,    // dimensions
+    tiled_matmul_compare(16, 50, 20,    // dimensions
     inter_results1, weights2, NULL, inter_results2,      // addresses
-    RELU, 0, 0, 0,           // act, shift, r6_shift
+    1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_2");
     // verbose(2,inter_results1,weights2,inter_results2)
     /* end of matmul number: 2 */
@@ -122,9 +117,9 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 3 */
 
-    tiled_matmul_compare(16, 64, 16,    // dimensions
+    tiled_matmul_compare(16, 10, 50,    // dimensions
     inter_results2, weights3, NULL, inter_results3,      // addresses
-    RELU, 0, 0, 0,           // act, shift, r6_shift
+    1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_3");
     // verbose(3,inter_results2,weights3,inter_results3)
     /* end of matmul number: 3 */
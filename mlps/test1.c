@@ -18,24 +18,15 @@ static void tiled_matmul_compare(size_t DIM_I, size_t DIM_J, size_t DIM_K,
     if (compare)
         printf("%s: gemmini\n", layer_name);
     tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-        A, B, D, C, no_bias, act, shift, relu6_shift,
+        A, B, no_bias ? NULL : D, C, act, shift, relu6_shift, 1,
         tiled_matmul_type);
 
     if (compare) {
-        printf("%s: CPU\n", layer_name);
-        elem_t gold[DIM_I][DIM_J];
-        tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-            A, B, D, gold, no_bias, act, shift, relu6_shift,
-            CPU);
-
-        printf("%s: comparing\n", layer_name);
-        for (size_t i = 0; i < DIM_I; i++) {
-            for (size_t j = 0; j < DIM_J; j++) {
-                if (C[i][j] != gold[i][j]) {
-                    printf("Layer calculated incorrectly: %s\n", layer_name);
-                    exit(1);
-                }
-            }
+        printf("%s: verifying\n", layer_name);
+        if (!tiled_matmul_verify(DIM_I, DIM_J, DIM_K,
+                A, B, no_bias ? NULL : D, NULL, C, act, shift, relu6_shift, 1)) {
+            printf("Layer calculated incorrectly: %s\n", layer_name);
+            exit(1);
         }
     }
 }
@@ -52,7 +43,7 @@ int main (int argc, char * argv[]) {
 
     enum tiled_matmul_type_t tiled_matmul_type;
     if (argc < 2) {
-        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', or cpu'\n");
+        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', 'cpu', 'auto', or 'hybrid'\n");
         // exit(0);
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "cpu") == 0) {
@@ -61,6 +52,10 @@ int main (int argc, char * argv[]) {
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "ws") == 0) {
         tiled_matmul_type = WS;
+    } else if (strcmp(argv[1], "auto") == 0) {
+        tiled_matmul_type = AUTO;
+    } else if (strcmp(argv[1], "hybrid") == 0) {
+        tiled_matmul_type = HYBRID;
     }
 
     bool compare;
@@ -80,7 +75,7 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 0 */
 
-    tiled_matmul_compare(64, 2560, 832,    // dimensions
+    tiled_matmul_compare(64, 2500, 784,    // dimensions
     input_mat, weights0, NULL, inter_results0,      // addresses
     1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_0");
@@ -94,7 +89,7 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 1 */
 
-    tiled_matmul_compare(64, 2048, 2560,    // dimensions
+    tiled_matmul_compare(64, 2000, 2500,    // dimensions
     inter_results0, weights1, NULL, inter_results1,      // addresses
     1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_1");
@@ -108,7 +103,7 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 2 */
 
-    tiled_matmul_compare(64, 1536, 2048,    // dimensions
+    tiled_matmul_compare(64, 1500, 2000,    // dimensions
     inter_results1, weights2, NULL, inter_results2,      // addresses
     1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_2");
@@ -122,7 +117,7 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 3 */
 
-    tiled_matmul_compare(64, 1024, 1536,    // dimensions
+    tiled_matmul_compare(64, 1000, 1500,    // dimensions
     inter_results2, weights3, NULL, inter_results3,      // addresses
     1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_3");
@@ -136,7 +131,7 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 4 */
 
-    tiled_matmul_compare(64, 512, 1024,    // dimensions
+    tiled_matmul_compare(64, 500, 1000,    // dimensions
     inter_results3, weights4, NULL, inter_results4,      // addresses
     1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_4");
@@ -150,7 +145,7 @@ int main (int argc, char * argv[]) {
 
     /* matmul number: 5 */
 
-    tiled_matmul_compare(64, 64, 512,    // dimensions
+    tiled_matmul_compare(64, 10, 500,    // dimensions
     inter_results4, weights5, NULL, inter_results5,      // addresses
     1, RELU, 0, 0,              // no_bias, act, shift, r6_shift
     tiled_matmul_type, compare, "layer_5");
@@ -11,38 +11,13 @@
 #define N 224
 
 
-static void tensor_reshape(int channels, elem_t in_tensor[][channels],int dim1,int dim2,int kdim, int stride, elem_t out_tensor[][channels]){
-    int w1,w2,channel,i,j;
-    int k = 0;
-    int row = 0;
-    for (w1=0;w1<dim1;w1+=stride){
-        for(w2=0;w2<dim2;w2+=stride){
-            k=0;
-            for(channel = 0; channel<channels; channel++){
-                for(i=-kdim/2;i<=kdim/2;i++){
-                    for(j=-kdim/2;j<=kdim/2;j++){
-                        if(i+w1<0 || i+w1>=dim1||j+w2<0 ||j+w2>=dim2)
-                            out_tensor[row][k]=0;
-                        else
-                            out_tensor[row][k]=in_tensor[dim2*(i+w1)+j+w2][channel];
-                        k++;
-                    }
-                }
-            }
-            row++; 
-        }
-    }
-}    
-static void avg_pool7(int len, elem_t in[][len],elem_t out[][len]){
-    int i, j;
-    for(i=0;i<len;i++){
-        for(j=0;j<7*7;j++){
-            out[0][i] += in[j][i];
-        }
-        out[0][i]=out[0][i]/49;
-    }
+// Builds the patch matrix of a conv with 'same' padding on an NHWC activation,
+// with patch rows out_row_len elements apart. The columns are in (kernel row,
+// kernel col, channel) order, so the kernels are laid out like tiled_conv's.
+static void tensor_reshape(int channels, elem_t in_tensor[][channels],int dim1,int dim2,int kdim, int stride, int out_row_len, elem_t out_tensor[][out_row_len]){
+    im2col_nhwc(1, channels, dim1, (dim1+stride-1)/stride, stride, kdim/2, kdim,
+        (void*)in_tensor, out_row_len, out_tensor);
 }
-
 static void rocket_fix_strided_dimension(int img_dim, int len2, elem_t in[][len2], int len3, elem_t out[][len3]){
         
     for(int i =0;i<img_dim;i+=2){
@@ -54,10 +29,29 @@ static void rocket_fix_strided_dimension(int img_dim, int len2, elem_t in[][len2
     }
 }
 
-static void rocket_zeropad(int dim1,int dim2, elem_t in[][dim2], int dim3, elem_t out[][dim3]){
-    for(int i = 0; i<dim1;i++){
-        for(int j =0; j<dim2;j++){
-            out[i][j] = in[i][j];
+// The shortcut of a residual block is added to the output of its last conv
+// inside the accumulator. A shortcut with fewer channels than the output only
+// adds to the first channels, so it doesn't need to be zero-padded first.
+static void tiled_matmul_residual_compare(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type,
+        bool compare, char * layer_name)
+{
+    if (compare)
+        printf("%s: gemmini\n", layer_name);
+    tiled_matmul_residual(DIM_I, DIM_J, DIM_K,
+        A, B, D, res, C, act, shift, relu6_shift, full_bias_width,
+        tiled_matmul_type);
+
+    if (compare) {
+        printf("%s: verifying\n", layer_name);
+        if (!tiled_matmul_verify(DIM_I, DIM_J, DIM_K,
+                A, B, D, res, C, act, shift, relu6_shift, full_bias_width)) {
+            printf("Layer calculated incorrectly: %s\n", layer_name);
+            exit(1);
         }
     }
 }
@@ -70,25 +64,53 @@ static void tiled_matmul_compare(size_t DIM_I, size_t DIM_J, size_t DIM_K,
         enum tiled_matmul_type_t tiled_matmul_type,
         bool compare, char * layer_name)
 {
-    if (compare)
-        printf("%s: gemmini\n", layer_name);
-    tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-        A, B, D, C, act, shift, relu6_shift, full_bias_width,
-        tiled_matmul_type);
+    tiled_matmul_residual_compare(DIM_I, DIM_J, DIM_K, A, B, D, NULL, C,
+        act, shift, relu6_shift, full_bias_width, tiled_matmul_type,
+        compare, layer_name);
+}
+
+// Runs a 3x3 conv with a stride of 1. With winograd, it's run with
+// tiled_conv_winograd, as long as its weights' transform fits in an elem_t
+// and its channels fit in the Winograd buffers, and with compare, it's then
+// checked to be within the Winograd tolerance of the exact conv. Otherwise,
+// it's a matmul on its patch matrix.
+static void conv3x3_compare(size_t img_dim, size_t channels,
+        size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t in[][channels], elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J],
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift,
+        enum tiled_matmul_type_t tiled_matmul_type,
+        bool winograd, bool compare, char * layer_name)
+{
+    static elem_t U[16*512*512] row_align(1);
+
+    const bool transformed = winograd &&
+        winograd_transform_weights(channels, DIM_J, B, (void*)U);
+
+    if (transformed && compare)
+        printf("%s: winograd\n", layer_name);
+
+    if (!transformed || !tiled_conv_winograd(1, img_dim, channels, DIM_J,
+            (void*)in, (void*)U, NULL, C, act, shift, 0, tiled_matmul_type)) {
+        tensor_reshape(channels, in, img_dim, img_dim, 3, 1, DIM_K, A);
+        tiled_matmul_compare(DIM_I, DIM_J, DIM_K, A, B, NULL, C,
+            act, shift, 0, 0, tiled_matmul_type, compare, layer_name);
+        return;
+    }
 
     if (compare) {
         printf("%s: CPU\n", layer_name);
         elem_t gold[DIM_I][DIM_J];
-        tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-            A, B, D, gold, act, shift, relu6_shift, full_bias_width,
-            CPU);
+        tensor_reshape(channels, in, img_dim, img_dim, 3, 1, DIM_K, A);
+        tiled_matmul_option(DIM_I, DIM_J, DIM_K, A, B, NULL, gold,
+            act, shift, 0, 0, CPU);
 
-        if (!MAT_IS_EQUAL(DIM_I, DIM_J, C, gold)) {
+        if (!winograd_within_tolerance(img_dim*img_dim*DIM_J, &C[0][0], &gold[0][0])) {
             printf("Layer calculated incorrectly: %s\n", layer_name);
             exit(1);
         }
     }
-}   
+}
 
 int main (int argc, char * argv[]) {
 #ifndef BAREMETAL
@@ -102,7 +124,7 @@ int main (int argc, char * argv[]) {
 
     enum tiled_matmul_type_t tiled_matmul_type;
     if (argc < 2) {
-        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', or cpu'\n");
+        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', 'cpu', 'auto', or 'hybrid'\n");
         // exit(0);
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "cpu") == 0) {
@@ -111,16 +133,22 @@ int main (int argc, char * argv[]) {
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "ws") == 0) {
         tiled_matmul_type = WS;
+    } else if (strcmp(argv[1], "auto") == 0) {
+        tiled_matmul_type = AUTO;
+    } else if (strcmp(argv[1], "hybrid") == 0) {
+        tiled_matmul_type = HYBRID;
     }
 
-    bool compare;
-    if (argc < 3) {
-        compare = false;
-    } else if (strcmp(argv[2], "compare") == 0) {
-        compare = true;
-    } else {
-        printf("Unknown command-line argument\n");
-        exit(1);
+    bool compare = false, winograd = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "compare") == 0) {
+            compare = true;
+        } else if (strcmp(argv[i], "winograd") == 0) {
+            winograd = true;
+        } else {
+            printf("Unknown command-line argument\n");
+            exit(1);
+        }
     }
 
 
@@ -131,7 +159,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel0[192][64] row_align(1)= {0};
     static elem_t tensor0[12544][192] row_align(1)= {0};
     static elem_t result0[12544][64] row_align(1)= {0};
-    tensor_reshape(3,img,224, 224, 7, 2, tensor0);
+    tensor_reshape(3,img,224, 224, 7, 2, LEN(tensor0[0]), tensor0);
 
 
     /* matmul number: 0 */
@@ -149,7 +177,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel1[576][64] row_align(1)= {0};
     static elem_t tensor1[3136][576] row_align(1)= {0};
     static elem_t result1[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result0,112, 112, 3, 2, tensor1);
+    tensor_reshape(64,result0,112, 112, 3, 2, LEN(tensor1[0]), tensor1);
 
 
     /* matmul number: 1 */
@@ -184,15 +212,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel3[576][64] row_align(1)= {0};
     static elem_t tensor3[3136][576] row_align(1)= {0};
     static elem_t result3[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result2,56, 56, 3, 1, tensor3);
 
 
     /* matmul number: 3 */
 
-    tiled_matmul_compare(3136, 64, 576,    // dimensions
-    tensor3, kernel3, NULL, result3,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_3");
+    conv3x3_compare(56, 64, 3136, 64, 576,    // dimensions
+    result2, tensor3, kernel3, result3,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_3");
     // verbose(3,tensor3,kernel3,result3)
     /* end of matmul number: 3 */
 
@@ -202,14 +229,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel4[64][256] row_align(1)= {0};
     static elem_t tensor4[3136][64] row_align(1)= {0};
     static elem_t result4[3136][256] row_align(1)= {0};
-    static elem_t inter_result4[3136][256] row_align(1)= {0};
-    rocket_zeropad(3136,64,result2,256,  inter_result4);
+    const struct tiled_matmul_residual_t residual4 = {&result2[0][0], 64, 64, 0};
 
 
     /* matmul number: 4 */
 
-    tiled_matmul_compare(3136, 256, 64,    // dimensions
-    tensor4, kernel4, inter_result4, result4,      // addresses
+    tiled_matmul_residual_compare(3136, 256, 64,    // dimensions
+    tensor4, kernel4, NULL, &residual4, result4,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_4");
     // verbose(4,tensor4,kernel4,result4)
@@ -238,15 +264,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel6[576][64] row_align(1)= {0};
     static elem_t tensor6[3136][576] row_align(1)= {0};
     static elem_t result6[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result5,56, 56, 3, 1, tensor6);
 
 
     /* matmul number: 6 */
 
-    tiled_matmul_compare(3136, 64, 576,    // dimensions
-    tensor6, kernel6, NULL, result6,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_6");
+    conv3x3_compare(56, 64, 3136, 64, 576,    // dimensions
+    result5, tensor6, kernel6, result6,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_6");
     // verbose(6,tensor6,kernel6,result6)
     /* end of matmul number: 6 */
 
@@ -256,14 +281,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel7[64][256] row_align(1)= {0};
     static elem_t tensor7[3136][64] row_align(1)= {0};
     static elem_t result7[3136][256] row_align(1)= {0};
-    static elem_t inter_result7[3136][256] row_align(1)= {0};
-    rocket_zeropad(3136,64,result5,256,  inter_result7);
+    const struct tiled_matmul_residual_t residual7 = {&result5[0][0], 64, 64, 0};
 
 
     /* matmul number: 7 */
 
-    tiled_matmul_compare(3136, 256, 64,    // dimensions
-    tensor7, kernel7, inter_result7, result7,      // addresses
+    tiled_matmul_residual_compare(3136, 256, 64,    // dimensions
+    tensor7, kernel7, NULL, &residual7, result7,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_7");
     // verbose(7,tensor7,kernel7,result7)
@@ -292,15 +316,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel9[576][64] row_align(1)= {0};
     static elem_t tensor9[3136][576] row_align(1)= {0};
     static elem_t result9[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result8,56, 56, 3, 1, tensor9);
 
 
     /* matmul number: 9 */
 
-    tiled_matmul_compare(3136, 64, 576,    // dimensions
-    tensor9, kernel9, NULL, result9,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_9");
+    conv3x3_compare(56, 64, 3136, 64, 576,    // dimensions
+    result8, tensor9, kernel9, result9,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_9");
     // verbose(9,tensor9,kernel9,result9)
     /* end of matmul number: 9 */
 
@@ -310,14 +333,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel10[64][256] row_align(1)= {0};
     static elem_t tensor10[3136][64] row_align(1)= {0};
     static elem_t result10[3136][256] row_align(1)= {0};
-    static elem_t inter_result10[3136][256] row_align(1)= {0};
-    rocket_zeropad(3136,64,result8,256,  inter_result10);
+    const struct tiled_matmul_residual_t residual10 = {&result8[0][0], 64, 64, 0};
 
 
     /* matmul number: 10 */
 
-    tiled_matmul_compare(3136, 256, 64,    // dimensions
-    tensor10, kernel10, inter_result10, result10,      // addresses
+    tiled_matmul_residual_compare(3136, 256, 64,    // dimensions
+    tensor10, kernel10, NULL, &residual10, result10,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_10");
     // verbose(10,tensor10,kernel10,result10)
@@ -346,7 +368,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel12[1152][128] row_align(1)= {0};
     static elem_t tensor12[832][1152] row_align(1)= {0};
     static elem_t result12[832][128] row_align(1)= {0};
-    tensor_reshape(128,result11,56, 56, 3, 2, tensor12);
+    tensor_reshape(128,result11,56, 56, 3, 2, LEN(tensor12[0]), tensor12);
 
 
     /* matmul number: 12 */
@@ -400,15 +422,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel15[1152][128] row_align(1)= {0};
     static elem_t tensor15[832][1152] row_align(1)= {0};
     static elem_t result15[832][128] row_align(1)= {0};
-    tensor_reshape(128,result14,28, 28, 3, 1, tensor15);
 
 
     /* matmul number: 15 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor15, kernel15, NULL, result15,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_15");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result14, tensor15, kernel15, result15,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_15");
     // verbose(15,tensor15,kernel15,result15)
     /* end of matmul number: 15 */
 
@@ -418,14 +439,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel16[128][512] row_align(1)= {0};
     static elem_t tensor16[832][128] row_align(1)= {0};
     static elem_t result16[832][512] row_align(1)= {0};
-    static elem_t inter_result16[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result14,512,  inter_result16);
+    const struct tiled_matmul_residual_t residual16 = {&result14[0][0], 128, 128, 0};
 
 
     /* matmul number: 16 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor16, kernel16, inter_result16, result16,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor16, kernel16, NULL, &residual16, result16,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_16");
     // verbose(16,tensor16,kernel16,result16)
@@ -454,15 +474,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel18[1152][128] row_align(1)= {0};
     static elem_t tensor18[832][1152] row_align(1)= {0};
     static elem_t result18[832][128] row_align(1)= {0};
-    tensor_reshape(128,result17,28, 28, 3, 1, tensor18);
 
 
     /* matmul number: 18 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor18, kernel18, NULL, result18,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_18");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result17, tensor18, kernel18, result18,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_18");
     // verbose(18,tensor18,kernel18,result18)
     /* end of matmul number: 18 */
 
@@ -472,14 +491,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel19[128][512] row_align(1)= {0};
     static elem_t tensor19[832][128] row_align(1)= {0};
     static elem_t result19[832][512] row_align(1)= {0};
-    static elem_t inter_result19[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result17,512,  inter_result19);
+    const struct tiled_matmul_residual_t residual19 = {&result17[0][0], 128, 128, 0};
 
 
     /* matmul number: 19 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor19, kernel19, inter_result19, result19,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor19, kernel19, NULL, &residual19, result19,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_19");
     // verbose(19,tensor19,kernel19,result19)
@@ -508,15 +526,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel21[1152][128] row_align(1)= {0};
     static elem_t tensor21[832][1152] row_align(1)= {0};
     static elem_t result21[832][128] row_align(1)= {0};
-    tensor_reshape(128,result20,28, 28, 3, 1, tensor21);
 
 
     /* matmul number: 21 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor21, kernel21, NULL, result21,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_21");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result20, tensor21, kernel21, result21,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_21");
     // verbose(21,tensor21,kernel21,result21)
     /* end of matmul number: 21 */
 
@@ -526,14 +543,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel22[128][512] row_align(1)= {0};
     static elem_t tensor22[832][128] row_align(1)= {0};
     static elem_t result22[832][512] row_align(1)= {0};
-    static elem_t inter_result22[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result20,512,  inter_result22);
+    const struct tiled_matmul_residual_t residual22 = {&result20[0][0], 128, 128, 0};
 
 
     /* matmul number: 22 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor22, kernel22, inter_result22, result22,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor22, kernel22, NULL, &residual22, result22,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_22");
     // verbose(22,tensor22,kernel22,result22)
@@ -562,15 +578,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel24[1152][128] row_align(1)= {0};
     static elem_t tensor24[832][1152] row_align(1)= {0};
     static elem_t result24[832][128] row_align(1)= {0};
-    tensor_reshape(128,result23,28, 28, 3, 1, tensor24);
 
 
     /* matmul number: 24 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor24, kernel24, NULL, result24,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_24");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result23, tensor24, kernel24, result24,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_24");
     // verbose(24,tensor24,kernel24,result24)
     /* end of matmul number: 24 */
 
@@ -580,14 +595,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel25[128][512] row_align(1)= {0};
     static elem_t tensor25[832][128] row_align(1)= {0};
     static elem_t result25[832][512] row_align(1)= {0};
-    static elem_t inter_result25[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result23,512,  inter_result25);
+    const struct tiled_matmul_residual_t residual25 = {&result23[0][0], 128, 128, 0};
 
 
     /* matmul number: 25 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor25, kernel25, inter_result25, result25,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor25, kernel25, NULL, &residual25, result25,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_25");
     // verbose(25,tensor25,kernel25,result25)
@@ -616,15 +630,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel27[1152][128] row_align(1)= {0};
     static elem_t tensor27[832][1152] row_align(1)= {0};
     static elem_t result27[832][128] row_align(1)= {0};
-    tensor_reshape(128,result26,28, 28, 3, 1, tensor27);
 
 
     /* matmul number: 27 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor27, kernel27, NULL, result27,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_27");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result26, tensor27, kernel27, result27,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_27");
     // verbose(27,tensor27,kernel27,result27)
     /* end of matmul number: 27 */
 
@@ -634,14 +647,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel28[128][512] row_align(1)= {0};
     static elem_t tensor28[832][128] row_align(1)= {0};
     static elem_t result28[832][512] row_align(1)= {0};
-    static elem_t inter_result28[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result26,512,  inter_result28);
+    const struct tiled_matmul_residual_t residual28 = {&result26[0][0], 128, 128, 0};
 
 
     /* matmul number: 28 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor28, kernel28, inter_result28, result28,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor28, kernel28, NULL, &residual28, result28,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_28");
     // verbose(28,tensor28,kernel28,result28)
@@ -670,15 +682,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel30[1152][128] row_align(1)= {0};
     static elem_t tensor30[832][1152] row_align(1)= {0};
     static elem_t result30[832][128] row_align(1)= {0};
-    tensor_reshape(128,result29,28, 28, 3, 1, tensor30);
 
 
     /* matmul number: 30 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor30, kernel30, NULL, result30,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_30");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result29, tensor30, kernel30, result30,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_30");
     // verbose(30,tensor30,kernel30,result30)
     /* end of matmul number: 30 */
 
@@ -688,14 +699,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel31[128][512] row_align(1)= {0};
     static elem_t tensor31[832][128] row_align(1)= {0};
     static elem_t result31[832][512] row_align(1)= {0};
-    static elem_t inter_result31[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result29,512,  inter_result31);
+    const struct tiled_matmul_residual_t residual31 = {&result29[0][0], 128, 128, 0};
 
 
     /* matmul number: 31 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor31, kernel31, inter_result31, result31,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor31, kernel31, NULL, &residual31, result31,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_31");
     // verbose(31,tensor31,kernel31,result31)
@@ -724,15 +734,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel33[1152][128] row_align(1)= {0};
     static elem_t tensor33[832][1152] row_align(1)= {0};
     static elem_t result33[832][128] row_align(1)= {0};
-    tensor_reshape(128,result32,28, 28, 3, 1, tensor33);
 
 
     /* matmul number: 33 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor33, kernel33, NULL, result33,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_33");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result32, tensor33, kernel33, result33,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_33");
     // verbose(33,tensor33,kernel33,result33)
     /* end of matmul number: 33 */
 
@@ -742,14 +751,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel34[128][512] row_align(1)= {0};
     static elem_t tensor34[832][128] row_align(1)= {0};
     static elem_t result34[832][512] row_align(1)= {0};
-    static elem_t inter_result34[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result32,512,  inter_result34);
+    const struct tiled_matmul_residual_t residual34 = {&result32[0][0], 128, 128, 0};
 
 
     /* matmul number: 34 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor34, kernel34, inter_result34, result34,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor34, kernel34, NULL, &residual34, result34,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_34");
     // verbose(34,tensor34,kernel34,result34)
@@ -778,7 +786,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel36[2304][256] row_align(1)= {0};
     static elem_t tensor36[256][2304] row_align(1)= {0};
     static elem_t result36[256][256] row_align(1)= {0};
-    tensor_reshape(256,result35,28, 28, 3, 2, tensor36);
+    tensor_reshape(256,result35,28, 28, 3, 2, LEN(tensor36[0]), tensor36);
 
 
     /* matmul number: 36 */
@@ -832,15 +840,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel39[2304][256] row_align(1)= {0};
     static elem_t tensor39[256][2304] row_align(1)= {0};
     static elem_t result39[256][256] row_align(1)= {0};
-    tensor_reshape(256,result38,14, 14, 3, 1, tensor39);
 
 
     /* matmul number: 39 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor39, kernel39, NULL, result39,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_39");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result38, tensor39, kernel39, result39,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_39");
     // verbose(39,tensor39,kernel39,result39)
     /* end of matmul number: 39 */
 
@@ -850,14 +857,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel40[256][1024] row_align(1)= {0};
     static elem_t tensor40[256][256] row_align(1)= {0};
     static elem_t result40[256][1024] row_align(1)= {0};
-    static elem_t inter_result40[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result38,1024,  inter_result40);
+    const struct tiled_matmul_residual_t residual40 = {&result38[0][0], 256, 256, 0};
 
 
     /* matmul number: 40 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor40, kernel40, inter_result40, result40,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor40, kernel40, NULL, &residual40, result40,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_40");
     // verbose(40,tensor40,kernel40,result40)
@@ -886,15 +892,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel42[2304][256] row_align(1)= {0};
     static elem_t tensor42[256][2304] row_align(1)= {0};
     static elem_t result42[256][256] row_align(1)= {0};
-    tensor_reshape(256,result41,14, 14, 3, 1, tensor42);
 
 
     /* matmul number: 42 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor42, kernel42, NULL, result42,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_42");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result41, tensor42, kernel42, result42,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_42");
     // verbose(42,tensor42,kernel42,result42)
     /* end of matmul number: 42 */
 
@@ -904,14 +909,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel43[256][1024] row_align(1)= {0};
     static elem_t tensor43[256][256] row_align(1)= {0};
     static elem_t result43[256][1024] row_align(1)= {0};
-    static elem_t inter_result43[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result41,1024,  inter_result43);
+    const struct tiled_matmul_residual_t residual43 = {&result41[0][0], 256, 256, 0};
 
 
     /* matmul number: 43 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor43, kernel43, inter_result43, result43,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor43, kernel43, NULL, &residual43, result43,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_43");
     // verbose(43,tensor43,kernel43,result43)
@@ -940,15 +944,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel45[2304][256] row_align(1)= {0};
     static elem_t tensor45[256][2304] row_align(1)= {0};
     static elem_t result45[256][256] row_align(1)= {0};
-    tensor_reshape(256,result44,14, 14, 3, 1, tensor45);
 
 
     /* matmul number: 45 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor45, kernel45, NULL, result45,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_45");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result44, tensor45, kernel45, result45,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_45");
     // verbose(45,tensor45,kernel45,result45)
     /* end of matmul number: 45 */
 
@@ -958,14 +961,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel46[256][1024] row_align(1)= {0};
     static elem_t tensor46[256][256] row_align(1)= {0};
     static elem_t result46[256][1024] row_align(1)= {0};
-    static elem_t inter_result46[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result44,1024,  inter_result46);
+    const struct tiled_matmul_residual_t residual46 = {&result44[0][0], 256, 256, 0};
 
 
     /* matmul number: 46 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor46, kernel46, inter_result46, result46,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor46, kernel46, NULL, &residual46, result46,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_46");
     // verbose(46,tensor46,kernel46,result46)
@@ -994,15 +996,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel48[2304][256] row_align(1)= {0};
     static elem_t tensor48[256][2304] row_align(1)= {0};
     static elem_t result48[256][256] row_align(1)= {0};
-    tensor_reshape(256,result47,14, 14, 3, 1, tensor48);
 
 
     /* matmul number: 48 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor48, kernel48, NULL, result48,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_48");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result47, tensor48, kernel48, result48,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_48");
     // verbose(48,tensor48,kernel48,result48)
     /* end of matmul number: 48 */
 
@@ -1012,14 +1013,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel49[256][1024] row_align(1)= {0};
     static elem_t tensor49[256][256] row_align(1)= {0};
     static elem_t result49[256][1024] row_align(1)= {0};
-    static elem_t inter_result49[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result47,1024,  inter_result49);
+    const struct tiled_matmul_residual_t residual49 = {&result47[0][0], 256, 256, 0};
 
 
     /* matmul number: 49 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor49, kernel49, inter_result49, result49,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor49, kernel49, NULL, &residual49, result49,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_49");
     // verbose(49,tensor49,kernel49,result49)
@@ -1048,15 +1048,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel51[2304][256] row_align(1)= {0};
     static elem_t tensor51[256][2304] row_align(1)= {0};
     static elem_t result51[256][256] row_align(1)= {0};
-    tensor_reshape(256,result50,14, 14, 3, 1, tensor51);
 
 
     /* matmul number: 51 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor51, kernel51, NULL, result51,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_51");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result50, tensor51, kernel51, result51,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_51");
     // verbose(51,tensor51,kernel51,result51)
     /* end of matmul number: 51 */
 
@@ -1066,14 +1065,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel52[256][1024] row_align(1)= {0};
     static elem_t tensor52[256][256] row_align(1)= {0};
     static elem_t result52[256][1024] row_align(1)= {0};
-    static elem_t inter_result52[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result50,1024,  inter_result52);
+    const struct tiled_matmul_residual_t residual52 = {&result50[0][0], 256, 256, 0};
 
 
     /* matmul number: 52 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor52, kernel52, inter_result52, result52,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor52, kernel52, NULL, &residual52, result52,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_52");
     // verbose(52,tensor52,kernel52,result52)
@@ -1102,15 +1100,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel54[2304][256] row_align(1)= {0};
     static elem_t tensor54[256][2304] row_align(1)= {0};
     static elem_t result54[256][256] row_align(1)= {0};
-    tensor_reshape(256,result53,14, 14, 3, 1, tensor54);
 
 
     /* matmul number: 54 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor54, kernel54, NULL, result54,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_54");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result53, tensor54, kernel54, result54,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_54");
     // verbose(54,tensor54,kernel54,result54)
     /* end of matmul number: 54 */
 
@@ -1120,14 +1117,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel55[256][1024] row_align(1)= {0};
     static elem_t tensor55[256][256] row_align(1)= {0};
     static elem_t result55[256][1024] row_align(1)= {0};
-    static elem_t inter_result55[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result53,1024,  inter_result55);
+    const struct tiled_matmul_residual_t residual55 = {&result53[0][0], 256, 256, 0};
 
 
     /* matmul number: 55 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor55, kernel55, inter_result55, result55,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor55, kernel55, NULL, &residual55, result55,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_55");
     // verbose(55,tensor55,kernel55,result55)
@@ -1156,15 +1152,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel57[2304][256] row_align(1)= {0};
     static elem_t tensor57[256][2304] row_align(1)= {0};
     static elem_t result57[256][256] row_align(1)= {0};
-    tensor_reshape(256,result56,14, 14, 3, 1, tensor57);
 
 
     /* matmul number: 57 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor57, kernel57, NULL, result57,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_57");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result56, tensor57, kernel57, result57,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_57");
     // verbose(57,tensor57,kernel57,result57)
     /* end of matmul number: 57 */
 
@@ -1174,14 +1169,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel58[256][1024] row_align(1)= {0};
     static elem_t tensor58[256][256] row_align(1)= {0};
     static elem_t result58[256][1024] row_align(1)= {0};
-    static elem_t inter_result58[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result56,1024,  inter_result58);
+    const struct tiled_matmul_residual_t residual58 = {&result56[0][0], 256, 256, 0};
 
 
     /* matmul number: 58 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor58, kernel58, inter_result58, result58,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor58, kernel58, NULL, &residual58, result58,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_58");
     // verbose(58,tensor58,kernel58,result58)
@@ -1210,15 +1204,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel60[2304][256] row_align(1)= {0};
     static elem_t tensor60[256][2304] row_align(1)= {0};
     static elem_t result60[256][256] row_align(1)= {0};
-    tensor_reshape(256,result59,14, 14, 3, 1, tensor60);
 
 
     /* matmul number: 60 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor60, kernel60, NULL, result60,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_60");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result59, tensor60, kernel60, result60,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_60");
     // verbose(60,tensor60,kernel60,result60)
     /* end of matmul number: 60 */
 
@@ -1228,14 +1221,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel61[256][1024] row_align(1)= {0};
     static elem_t tensor61[256][256] row_align(1)= {0};
     static elem_t result61[256][1024] row_align(1)= {0};
-    static elem_t inter_result61[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result59,1024,  inter_result61);
+    const struct tiled_matmul_residual_t residual61 = {&result59[0][0], 256, 256, 0};
 
 
     /* matmul number: 61 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor61, kernel61, inter_result61, result61,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor61, kernel61, NULL, &residual61, result61,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_61");
     // verbose(61,tensor61,kernel61,result61)
@@ -1264,15 +1256,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel63[2304][256] row_align(1)= {0};
     static elem_t tensor63[256][2304] row_align(1)= {0};
     static elem_t result63[256][256] row_align(1)= {0};
-    tensor_reshape(256,result62,14, 14, 3, 1, tensor63);
 
 
     /* matmul number: 63 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor63, kernel63, NULL, result63,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_63");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result62, tensor63, kernel63, result63,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_63");
     // verbose(63,tensor63,kernel63,result63)
     /* end of matmul number: 63 */
 
@@ -1282,14 +1273,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel64[256][1024] row_align(1)= {0};
     static elem_t tensor64[256][256] row_align(1)= {0};
     static elem_t result64[256][1024] row_align(1)= {0};
-    static elem_t inter_result64[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result62,1024,  inter_result64);
+    const struct tiled_matmul_residual_t residual64 = {&result62[0][0], 256, 256, 0};
 
 
     /* matmul number: 64 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor64, kernel64, inter_result64, result64,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor64, kernel64, NULL, &residual64, result64,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_64");
     // verbose(64,tensor64,kernel64,result64)
@@ -1318,15 +1308,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel66[2304][256] row_align(1)= {0};
     static elem_t tensor66[256][2304] row_align(1)= {0};
     static elem_t result66[256][256] row_align(1)= {0};
-    tensor_reshape(256,result65,14, 14, 3, 1, tensor66);
 
 
     /* matmul number: 66 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor66, kernel66, NULL, result66,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_66");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result65, tensor66, kernel66, result66,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_66");
     // verbose(66,tensor66,kernel66,result66)
     /* end of matmul number: 66 */
 
@@ -1336,14 +1325,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel67[256][1024] row_align(1)= {0};
     static elem_t tensor67[256][256] row_align(1)= {0};
     static elem_t result67[256][1024] row_align(1)= {0};
-    static elem_t inter_result67[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result65,1024,  inter_result67);
+    const struct tiled_matmul_residual_t residual67 = {&result65[0][0], 256, 256, 0};
 
 
     /* matmul number: 67 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor67, kernel67, inter_result67, result67,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor67, kernel67, NULL, &residual67, result67,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_67");
     // verbose(67,tensor67,kernel67,result67)
@@ -1372,15 +1360,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel69[2304][256] row_align(1)= {0};
     static elem_t tensor69[256][2304] row_align(1)= {0};
     static elem_t result69[256][256] row_align(1)= {0};
-    tensor_reshape(256,result68,14, 14, 3, 1, tensor69);
 
 
     /* matmul number: 69 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor69, kernel69, NULL, result69,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_69");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result68, tensor69, kernel69, result69,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_69");
     // verbose(69,tensor69,kernel69,result69)
     /* end of matmul number: 69 */
 
@@ -1390,14 +1377,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel70[256][1024] row_align(1)= {0};
     static elem_t tensor70[256][256] row_align(1)= {0};
     static elem_t result70[256][1024] row_align(1)= {0};
-    static elem_t inter_result70[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result68,1024,  inter_result70);
+    const struct tiled_matmul_residual_t residual70 = {&result68[0][0], 256, 256, 0};
 
 
     /* matmul number: 70 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor70, kernel70, inter_result70, result70,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor70, kernel70, NULL, &residual70, result70,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_70");
     // verbose(70,tensor70,kernel70,result70)
@@ -1426,15 +1412,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel72[2304][256] row_align(1)= {0};
     static elem_t tensor72[256][2304] row_align(1)= {0};
     static elem_t result72[256][256] row_align(1)= {0};
-    tensor_reshape(256,result71,14, 14, 3, 1, tensor72);
 
 
     /* matmul number: 72 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor72, kernel72, NULL, result72,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_72");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result71, tensor72, kernel72, result72,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_72");
     // verbose(72,tensor72,kernel72,result72)
     /* end of matmul number: 72 */
 
@@ -1444,14 +1429,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel73[256][1024] row_align(1)= {0};
     static elem_t tensor73[256][256] row_align(1)= {0};
     static elem_t result73[256][1024] row_align(1)= {0};
-    static elem_t inter_result73[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result71,1024,  inter_result73);
+    const struct tiled_matmul_residual_t residual73 = {&result71[0][0], 256, 256, 0};
 
 
     /* matmul number: 73 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor73, kernel73, inter_result73, result73,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor73, kernel73, NULL, &residual73, result73,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_73");
     // verbose(73,tensor73,kernel73,result73)
@@ -1480,15 +1464,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel75[2304][256] row_align(1)= {0};
     static elem_t tensor75[256][2304] row_align(1)= {0};
     static elem_t result75[256][256] row_align(1)= {0};
-    tensor_reshape(256,result74,14, 14, 3, 1, tensor75);
 
 
     /* matmul number: 75 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor75, kernel75, NULL, result75,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_75");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result74, tensor75, kernel75, result75,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_75");
     // verbose(75,tensor75,kernel75,result75)
     /* end of matmul number: 75 */
 
@@ -1498,14 +1481,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel76[256][1024] row_align(1)= {0};
     static elem_t tensor76[256][256] row_align(1)= {0};
     static elem_t result76[256][1024] row_align(1)= {0};
-    static elem_t inter_result76[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result74,1024,  inter_result76);
+    const struct tiled_matmul_residual_t residual76 = {&result74[0][0], 256, 256, 0};
 
 
     /* matmul number: 76 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor76, kernel76, inter_result76, result76,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor76, kernel76, NULL, &residual76, result76,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_76");
     // verbose(76,tensor76,kernel76,result76)
@@ -1534,15 +1516,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel78[2304][256] row_align(1)= {0};
     static elem_t tensor78[256][2304] row_align(1)= {0};
     static elem_t result78[256][256] row_align(1)= {0};
-    tensor_reshape(256,result77,14, 14, 3, 1, tensor78);
 
 
     /* matmul number: 78 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor78, kernel78, NULL, result78,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_78");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result77, tensor78, kernel78, result78,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_78");
     // verbose(78,tensor78,kernel78,result78)
     /* end of matmul number: 78 */
 
@@ -1552,14 +1533,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel79[256][1024] row_align(1)= {0};
     static elem_t tensor79[256][256] row_align(1)= {0};
     static elem_t result79[256][1024] row_align(1)= {0};
-    static elem_t inter_result79[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result77,1024,  inter_result79);
+    const struct tiled_matmul_residual_t residual79 = {&result77[0][0], 256, 256, 0};
 
 
     /* matmul number: 79 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor79, kernel79, inter_result79, result79,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor79, kernel79, NULL, &residual79, result79,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_79");
     // verbose(79,tensor79,kernel79,result79)
@@ -1588,15 +1568,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel81[2304][256] row_align(1)= {0};
     static elem_t tensor81[256][2304] row_align(1)= {0};
     static elem_t result81[256][256] row_align(1)= {0};
-    tensor_reshape(256,result80,14, 14, 3, 1, tensor81);
 
 
     /* matmul number: 81 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor81, kernel81, NULL, result81,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_81");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result80, tensor81, kernel81, result81,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_81");
     // verbose(81,tensor81,kernel81,result81)
     /* end of matmul number: 81 */
 
@@ -1606,14 +1585,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel82[256][1024] row_align(1)= {0};
     static elem_t tensor82[256][256] row_align(1)= {0};
     static elem_t result82[256][1024] row_align(1)= {0};
-    static elem_t inter_result82[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result80,1024,  inter_result82);
+    const struct tiled_matmul_residual_t residual82 = {&result80[0][0], 256, 256, 0};
 
 
     /* matmul number: 82 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor82, kernel82, inter_result82, result82,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor82, kernel82, NULL, &residual82, result82,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_82");
     // verbose(82,tensor82,kernel82,result82)
@@ -1642,15 +1620,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel84[2304][256] row_align(1)= {0};
     static elem_t tensor84[256][2304] row_align(1)= {0};
     static elem_t result84[256][256] row_align(1)= {0};
-    tensor_reshape(256,result83,14, 14, 3, 1, tensor84);
 
 
     /* matmul number: 84 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor84, kernel84, NULL, result84,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_84");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result83, tensor84, kernel84, result84,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_84");
     // verbose(84,tensor84,kernel84,result84)
     /* end of matmul number: 84 */
 
@@ -1660,14 +1637,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel85[256][1024] row_align(1)= {0};
     static elem_t tensor85[256][256] row_align(1)= {0};
     static elem_t result85[256][1024] row_align(1)= {0};
-    static elem_t inter_result85[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result83,1024,  inter_result85);
+    const struct tiled_matmul_residual_t residual85 = {&result83[0][0], 256, 256, 0};
 
 
     /* matmul number: 85 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor85, kernel85, inter_result85, result85,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor85, kernel85, NULL, &residual85, result85,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_85");
     // verbose(85,tensor85,kernel85,result85)
@@ -1696,15 +1672,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel87[2304][256] row_align(1)= {0};
     static elem_t tensor87[256][2304] row_align(1)= {0};
     static elem_t result87[256][256] row_align(1)= {0};
-    tensor_reshape(256,result86,14, 14, 3, 1, tensor87);
 
 
     /* matmul number: 87 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor87, kernel87, NULL, result87,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_87");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result86, tensor87, kernel87, result87,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_87");
     // verbose(87,tensor87,kernel87,result87)
     /* end of matmul number: 87 */
 
@@ -1714,14 +1689,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel88[256][1024] row_align(1)= {0};
     static elem_t tensor88[256][256] row_align(1)= {0};
     static elem_t result88[256][1024] row_align(1)= {0};
-    static elem_t inter_result88[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result86,1024,  inter_result88);
+    const struct tiled_matmul_residual_t residual88 = {&result86[0][0], 256, 256, 0};
 
 
     /* matmul number: 88 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor88, kernel88, inter_result88, result88,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor88, kernel88, NULL, &residual88, result88,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_88");
     // verbose(88,tensor88,kernel88,result88)
@@ -1750,15 +1724,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel90[2304][256] row_align(1)= {0};
     static elem_t tensor90[256][2304] row_align(1)= {0};
     static elem_t result90[256][256] row_align(1)= {0};
-    tensor_reshape(256,result89,14, 14, 3, 1, tensor90);
 
 
     /* matmul number: 90 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor90, kernel90, NULL, result90,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_90");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result89, tensor90, kernel90, result90,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_90");
     // verbose(90,tensor90,kernel90,result90)
     /* end of matmul number: 90 */
 
@@ -1768,14 +1741,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel91[256][1024] row_align(1)= {0};
     static elem_t tensor91[256][256] row_align(1)= {0};
     static elem_t result91[256][1024] row_align(1)= {0};
-    static elem_t inter_result91[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result89,1024,  inter_result91);
+    const struct tiled_matmul_residual_t residual91 = {&result89[0][0], 256, 256, 0};
 
 
     /* matmul number: 91 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor91, kernel91, inter_result91, result91,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor91, kernel91, NULL, &residual91, result91,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_91");
     // verbose(91,tensor91,kernel91,result91)
@@ -1804,15 +1776,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel93[2304][256] row_align(1)= {0};
     static elem_t tensor93[256][2304] row_align(1)= {0};
     static elem_t result93[256][256] row_align(1)= {0};
-    tensor_reshape(256,result92,14, 14, 3, 1, tensor93);
 
 
     /* matmul number: 93 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor93, kernel93, NULL, result93,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_93");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result92, tensor93, kernel93, result93,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_93");
     // verbose(93,tensor93,kernel93,result93)
     /* end of matmul number: 93 */
 
@@ -1822,14 +1793,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel94[256][1024] row_align(1)= {0};
     static elem_t tensor94[256][256] row_align(1)= {0};
     static elem_t result94[256][1024] row_align(1)= {0};
-    static elem_t inter_result94[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result92,1024,  inter_result94);
+    const struct tiled_matmul_residual_t residual94 = {&result92[0][0], 256, 256, 0};
 
 
     /* matmul number: 94 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor94, kernel94, inter_result94, result94,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor94, kernel94, NULL, &residual94, result94,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_94");
     // verbose(94,tensor94,kernel94,result94)
@@ -1858,15 +1828,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel96[2304][256] row_align(1)= {0};
     static elem_t tensor96[256][2304] row_align(1)= {0};
     static elem_t result96[256][256] row_align(1)= {0};
-    tensor_reshape(256,result95,14, 14, 3, 1, tensor96);
 
 
     /* matmul number: 96 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor96, kernel96, NULL, result96,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_96");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result95, tensor96, kernel96, result96,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_96");
     // verbose(96,tensor96,kernel96,result96)
     /* end of matmul number: 96 */
 
@@ -1876,14 +1845,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel97[256][1024] row_align(1)= {0};
     static elem_t tensor97[256][256] row_align(1)= {0};
     static elem_t result97[256][1024] row_align(1)= {0};
-    static elem_t inter_result97[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result95,1024,  inter_result97);
+    const struct tiled_matmul_residual_t residual97 = {&result95[0][0], 256, 256, 0};
 
 
     /* matmul number: 97 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor97, kernel97, inter_result97, result97,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor97, kernel97, NULL, &residual97, result97,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_97");
     // verbose(97,tensor97,kernel97,result97)
@@ -1912,15 +1880,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel99[2304][256] row_align(1)= {0};
     static elem_t tensor99[256][2304] row_align(1)= {0};
     static elem_t result99[256][256] row_align(1)= {0};
-    tensor_reshape(256,result98,14, 14, 3, 1, tensor99);
 
 
     /* matmul number: 99 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor99, kernel99, NULL, result99,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_99");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result98, tensor99, kernel99, result99,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_99");
     // verbose(99,tensor99,kernel99,result99)
     /* end of matmul number: 99 */
 
@@ -1930,14 +1897,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel100[256][1024] row_align(1)= {0};
     static elem_t tensor100[256][256] row_align(1)= {0};
     static elem_t result100[256][1024] row_align(1)= {0};
-    static elem_t inter_result100[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result98,1024,  inter_result100);
+    const struct tiled_matmul_residual_t residual100 = {&result98[0][0], 256, 256, 0};
 
 
     /* matmul number: 100 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor100, kernel100, inter_result100, result100,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor100, kernel100, NULL, &residual100, result100,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_100");
     // verbose(100,tensor100,kernel100,result100)
@@ -1966,15 +1932,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel102[2304][256] row_align(1)= {0};
     static elem_t tensor102[256][2304] row_align(1)= {0};
     static elem_t result102[256][256] row_align(1)= {0};
-    tensor_reshape(256,result101,14, 14, 3, 1, tensor102);
 
 
     /* matmul number: 102 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor102, kernel102, NULL, result102,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_102");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result101, tensor102, kernel102, result102,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_102");
     // verbose(102,tensor102,kernel102,result102)
     /* end of matmul number: 102 */
 
@@ -1984,14 +1949,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel103[256][1024] row_align(1)= {0};
     static elem_t tensor103[256][256] row_align(1)= {0};
     static elem_t result103[256][1024] row_align(1)= {0};
-    static elem_t inter_result103[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result101,1024,  inter_result103);
+    const struct tiled_matmul_residual_t residual103 = {&result101[0][0], 256, 256, 0};
 
 
     /* matmul number: 103 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor103, kernel103, inter_result103, result103,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor103, kernel103, NULL, &residual103, result103,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_103");
     // verbose(103,tensor103,kernel103,result103)
@@ -2020,15 +1984,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel105[2304][256] row_align(1)= {0};
     static elem_t tensor105[256][2304] row_align(1)= {0};
     static elem_t result105[256][256] row_align(1)= {0};
-    tensor_reshape(256,result104,14, 14, 3, 1, tensor105);
 
 
     /* matmul number: 105 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor105, kernel105, NULL, result105,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_105");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result104, tensor105, kernel105, result105,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_105");
     // verbose(105,tensor105,kernel105,result105)
     /* end of matmul number: 105 */
 
@@ -2038,14 +2001,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel106[256][1024] row_align(1)= {0};
     static elem_t tensor106[256][256] row_align(1)= {0};
     static elem_t result106[256][1024] row_align(1)= {0};
-    static elem_t inter_result106[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result104,1024,  inter_result106);
+    const struct tiled_matmul_residual_t residual106 = {&result104[0][0], 256, 256, 0};
 
 
     /* matmul number: 106 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor106, kernel106, inter_result106, result106,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor106, kernel106, NULL, &residual106, result106,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_106");
     // verbose(106,tensor106,kernel106,result106)
@@ -2074,15 +2036,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel108[2304][256] row_align(1)= {0};
     static elem_t tensor108[256][2304] row_align(1)= {0};
     static elem_t result108[256][256] row_align(1)= {0};
-    tensor_reshape(256,result107,14, 14, 3, 1, tensor108);
 
 
     /* matmul number: 108 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor108, kernel108, NULL, result108,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_108");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result107, tensor108, kernel108, result108,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_108");
     // verbose(108,tensor108,kernel108,result108)
     /* end of matmul number: 108 */
 
@@ -2092,14 +2053,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel109[256][1024] row_align(1)= {0};
     static elem_t tensor109[256][256] row_align(1)= {0};
     static elem_t result109[256][1024] row_align(1)= {0};
-    static elem_t inter_result109[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result107,1024,  inter_result109);
+    const struct tiled_matmul_residual_t residual109 = {&result107[0][0], 256, 256, 0};
 
 
     /* matmul number: 109 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor109, kernel109, inter_result109, result109,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor109, kernel109, NULL, &residual109, result109,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_109");
     // verbose(109,tensor109,kernel109,result109)
@@ -2128,15 +2088,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel111[2304][256] row_align(1)= {0};
     static elem_t tensor111[256][2304] row_align(1)= {0};
     static elem_t result111[256][256] row_align(1)= {0};
-    tensor_reshape(256,result110,14, 14, 3, 1, tensor111);
 
 
     /* matmul number: 111 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor111, kernel111, NULL, result111,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_111");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result110, tensor111, kernel111, result111,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_111");
     // verbose(111,tensor111,kernel111,result111)
     /* end of matmul number: 111 */
 
@@ -2146,14 +2105,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel112[256][1024] row_align(1)= {0};
     static elem_t tensor112[256][256] row_align(1)= {0};
     static elem_t result112[256][1024] row_align(1)= {0};
-    static elem_t inter_result112[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result110,1024,  inter_result112);
+    const struct tiled_matmul_residual_t residual112 = {&result110[0][0], 256, 256, 0};
 
 
     /* matmul number: 112 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor112, kernel112, inter_result112, result112,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor112, kernel112, NULL, &residual112, result112,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_112");
     // verbose(112,tensor112,kernel112,result112)
@@ -2182,15 +2140,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel114[2304][256] row_align(1)= {0};
     static elem_t tensor114[256][2304] row_align(1)= {0};
     static elem_t result114[256][256] row_align(1)= {0};
-    tensor_reshape(256,result113,14, 14, 3, 1, tensor114);
 
 
     /* matmul number: 114 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor114, kernel114, NULL, result114,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_114");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result113, tensor114, kernel114, result114,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_114");
     // verbose(114,tensor114,kernel114,result114)
     /* end of matmul number: 114 */
 
@@ -2200,14 +2157,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel115[256][1024] row_align(1)= {0};
     static elem_t tensor115[256][256] row_align(1)= {0};
     static elem_t result115[256][1024] row_align(1)= {0};
-    static elem_t inter_result115[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result113,1024,  inter_result115);
+    const struct tiled_matmul_residual_t residual115 = {&result113[0][0], 256, 256, 0};
 
 
     /* matmul number: 115 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor115, kernel115, inter_result115, result115,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor115, kernel115, NULL, &residual115, result115,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_115");
     // verbose(115,tensor115,kernel115,result115)
@@ -2236,15 +2192,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel117[2304][256] row_align(1)= {0};
     static elem_t tensor117[256][2304] row_align(1)= {0};
     static elem_t result117[256][256] row_align(1)= {0};
-    tensor_reshape(256,result116,14, 14, 3, 1, tensor117);
 
 
     /* matmul number: 117 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor117, kernel117, NULL, result117,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_117");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result116, tensor117, kernel117, result117,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_117");
     // verbose(117,tensor117,kernel117,result117)
     /* end of matmul number: 117 */
 
@@ -2254,14 +2209,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel118[256][1024] row_align(1)= {0};
     static elem_t tensor118[256][256] row_align(1)= {0};
     static elem_t result118[256][1024] row_align(1)= {0};
-    static elem_t inter_result118[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result116,1024,  inter_result118);
+    const struct tiled_matmul_residual_t residual118 = {&result116[0][0], 256, 256, 0};
 
 
     /* matmul number: 118 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor118, kernel118, inter_result118, result118,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor118, kernel118, NULL, &residual118, result118,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_118");
     // verbose(118,tensor118,kernel118,result118)
@@ -2290,15 +2244,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel120[2304][256] row_align(1)= {0};
     static elem_t tensor120[256][2304] row_align(1)= {0};
     static elem_t result120[256][256] row_align(1)= {0};
-    tensor_reshape(256,result119,14, 14, 3, 1, tensor120);
 
 
     /* matmul number: 120 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor120, kernel120, NULL, result120,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_120");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result119, tensor120, kernel120, result120,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_120");
     // verbose(120,tensor120,kernel120,result120)
     /* end of matmul number: 120 */
 
@@ -2308,14 +2261,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel121[256][1024] row_align(1)= {0};
     static elem_t tensor121[256][256] row_align(1)= {0};
     static elem_t result121[256][1024] row_align(1)= {0};
-    static elem_t inter_result121[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result119,1024,  inter_result121);
+    const struct tiled_matmul_residual_t residual121 = {&result119[0][0], 256, 256, 0};
 
 
     /* matmul number: 121 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor121, kernel121, inter_result121, result121,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor121, kernel121, NULL, &residual121, result121,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_121");
     // verbose(121,tensor121,kernel121,result121)
@@ -2344,15 +2296,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel123[2304][256] row_align(1)= {0};
     static elem_t tensor123[256][2304] row_align(1)= {0};
     static elem_t result123[256][256] row_align(1)= {0};
-    tensor_reshape(256,result122,14, 14, 3, 1, tensor123);
 
 
     /* matmul number: 123 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor123, kernel123, NULL, result123,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_123");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result122, tensor123, kernel123, result123,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_123");
     // verbose(123,tensor123,kernel123,result123)
     /* end of matmul number: 123 */
 
@@ -2362,14 +2313,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel124[256][1024] row_align(1)= {0};
     static elem_t tensor124[256][256] row_align(1)= {0};
     static elem_t result124[256][1024] row_align(1)= {0};
-    static elem_t inter_result124[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result122,1024,  inter_result124);
+    const struct tiled_matmul_residual_t residual124 = {&result122[0][0], 256, 256, 0};
 
 
     /* matmul number: 124 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor124, kernel124, inter_result124, result124,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor124, kernel124, NULL, &residual124, result124,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_124");
     // verbose(124,tensor124,kernel124,result124)
@@ -2398,15 +2348,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel126[2304][256] row_align(1)= {0};
     static elem_t tensor126[256][2304] row_align(1)= {0};
     static elem_t result126[256][256] row_align(1)= {0};
-    tensor_reshape(256,result125,14, 14, 3, 1, tensor126);
 
 
     /* matmul number: 126 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor126, kernel126, NULL, result126,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_126");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result125, tensor126, kernel126, result126,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_126");
     // verbose(126,tensor126,kernel126,result126)
     /* end of matmul number: 126 */
 
@@ -2416,14 +2365,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel127[256][1024] row_align(1)= {0};
     static elem_t tensor127[256][256] row_align(1)= {0};
     static elem_t result127[256][1024] row_align(1)= {0};
-    static elem_t inter_result127[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result125,1024,  inter_result127);
+    const struct tiled_matmul_residual_t residual127 = {&result125[0][0], 256, 256, 0};
 
 
     /* matmul number: 127 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor127, kernel127, inter_result127, result127,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor127, kernel127, NULL, &residual127, result127,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_127");
     // verbose(127,tensor127,kernel127,result127)
@@ -2452,15 +2400,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel129[2304][256] row_align(1)= {0};
     static elem_t tensor129[256][2304] row_align(1)= {0};
     static elem_t result129[256][256] row_align(1)= {0};
-    tensor_reshape(256,result128,14, 14, 3, 1, tensor129);
 
 
     /* matmul number: 129 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor129, kernel129, NULL, result129,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_129");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result128, tensor129, kernel129, result129,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_129");
     // verbose(129,tensor129,kernel129,result129)
     /* end of matmul number: 129 */
 
@@ -2470,14 +2417,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel130[256][1024] row_align(1)= {0};
     static elem_t tensor130[256][256] row_align(1)= {0};
     static elem_t result130[256][1024] row_align(1)= {0};
-    static elem_t inter_result130[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result128,1024,  inter_result130);
+    const struct tiled_matmul_residual_t residual130 = {&result128[0][0], 256, 256, 0};
 
 
     /* matmul number: 130 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor130, kernel130, inter_result130, result130,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor130, kernel130, NULL, &residual130, result130,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_130");
     // verbose(130,tensor130,kernel130,result130)
@@ -2506,15 +2452,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel132[2304][256] row_align(1)= {0};
     static elem_t tensor132[256][2304] row_align(1)= {0};
     static elem_t result132[256][256] row_align(1)= {0};
-    tensor_reshape(256,result131,14, 14, 3, 1, tensor132);
 
 
     /* matmul number: 132 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor132, kernel132, NULL, result132,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_132");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result131, tensor132, kernel132, result132,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_132");
     // verbose(132,tensor132,kernel132,result132)
     /* end of matmul number: 132 */
 
@@ -2524,14 +2469,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel133[256][1024] row_align(1)= {0};
     static elem_t tensor133[256][256] row_align(1)= {0};
     static elem_t result133[256][1024] row_align(1)= {0};
-    static elem_t inter_result133[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result131,1024,  inter_result133);
+    const struct tiled_matmul_residual_t residual133 = {&result131[0][0], 256, 256, 0};
 
 
     /* matmul number: 133 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor133, kernel133, inter_result133, result133,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor133, kernel133, NULL, &residual133, result133,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_133");
     // verbose(133,tensor133,kernel133,result133)
@@ -2560,15 +2504,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel135[2304][256] row_align(1)= {0};
     static elem_t tensor135[256][2304] row_align(1)= {0};
     static elem_t result135[256][256] row_align(1)= {0};
-    tensor_reshape(256,result134,14, 14, 3, 1, tensor135);
 
 
     /* matmul number: 135 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor135, kernel135, NULL, result135,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_135");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result134, tensor135, kernel135, result135,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_135");
     // verbose(135,tensor135,kernel135,result135)
     /* end of matmul number: 135 */
 
@@ -2578,14 +2521,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel136[256][1024] row_align(1)= {0};
     static elem_t tensor136[256][256] row_align(1)= {0};
     static elem_t result136[256][1024] row_align(1)= {0};
-    static elem_t inter_result136[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result134,1024,  inter_result136);
+    const struct tiled_matmul_residual_t residual136 = {&result134[0][0], 256, 256, 0};
 
 
     /* matmul number: 136 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor136, kernel136, inter_result136, result136,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor136, kernel136, NULL, &residual136, result136,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_136");
     // verbose(136,tensor136,kernel136,result136)
@@ -2614,15 +2556,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel138[2304][256] row_align(1)= {0};
     static elem_t tensor138[256][2304] row_align(1)= {0};
     static elem_t result138[256][256] row_align(1)= {0};
-    tensor_reshape(256,result137,14, 14, 3, 1, tensor138);
 
 
     /* matmul number: 138 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor138, kernel138, NULL, result138,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_138");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result137, tensor138, kernel138, result138,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_138");
     // verbose(138,tensor138,kernel138,result138)
     /* end of matmul number: 138 */
 
@@ -2632,14 +2573,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel139[256][1024] row_align(1)= {0};
     static elem_t tensor139[256][256] row_align(1)= {0};
     static elem_t result139[256][1024] row_align(1)= {0};
-    static elem_t inter_result139[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result137,1024,  inter_result139);
+    const struct tiled_matmul_residual_t residual139 = {&result137[0][0], 256, 256, 0};
 
 
     /* matmul number: 139 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor139, kernel139, inter_result139, result139,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor139, kernel139, NULL, &residual139, result139,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_139");
     // verbose(139,tensor139,kernel139,result139)
@@ -2668,15 +2608,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel141[2304][256] row_align(1)= {0};
     static elem_t tensor141[256][2304] row_align(1)= {0};
     static elem_t result141[256][256] row_align(1)= {0};
-    tensor_reshape(256,result140,14, 14, 3, 1, tensor141);
 
 
     /* matmul number: 141 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor141, kernel141, NULL, result141,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_141");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result140, tensor141, kernel141, result141,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_141");
     // verbose(141,tensor141,kernel141,result141)
     /* end of matmul number: 141 */
 
@@ -2686,14 +2625,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel142[256][1024] row_align(1)= {0};
     static elem_t tensor142[256][256] row_align(1)= {0};
     static elem_t result142[256][1024] row_align(1)= {0};
-    static elem_t inter_result142[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result140,1024,  inter_result142);
+    const struct tiled_matmul_residual_t residual142 = {&result140[0][0], 256, 256, 0};
 
 
     /* matmul number: 142 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor142, kernel142, inter_result142, result142,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor142, kernel142, NULL, &residual142, result142,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_142");
     // verbose(142,tensor142,kernel142,result142)
@@ -2722,7 +2660,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel144[4608][512] row_align(1)= {0};
     static elem_t tensor144[64][4608] row_align(1)= {0};
     static elem_t result144[64][512] row_align(1)= {0};
-    tensor_reshape(512,result143,14, 14, 3, 2, tensor144);
+    tensor_reshape(512,result143,14, 14, 3, 2, LEN(tensor144[0]), tensor144);
 
 
     /* matmul number: 144 */
@@ -2776,15 +2714,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel147[4608][512] row_align(1)= {0};
     static elem_t tensor147[64][4608] row_align(1)= {0};
     static elem_t result147[64][512] row_align(1)= {0};
-    tensor_reshape(512,result146,7, 7, 3, 1, tensor147);
 
 
     /* matmul number: 147 */
 
-    tiled_matmul_compare(64, 512, 4608,    // dimensions
-    tensor147, kernel147, NULL, result147,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_147");
+    conv3x3_compare(7, 512, 64, 512, 4608,    // dimensions
+    result146, tensor147, kernel147, result147,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_147");
     // verbose(147,tensor147,kernel147,result147)
     /* end of matmul number: 147 */
 
@@ -2794,14 +2731,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel148[512][2048] row_align(1)= {0};
     static elem_t tensor148[64][512] row_align(1)= {0};
     static elem_t result148[64][2048] row_align(1)= {0};
-    static elem_t inter_result148[64][2048] row_align(1)= {0};
-    rocket_zeropad(64,512,result146,2048,  inter_result148);
+    const struct tiled_matmul_residual_t residual148 = {&result146[0][0], 512, 512, 0};
 
 
     /* matmul number: 148 */
 
-    tiled_matmul_compare(64, 2048, 512,    // dimensions
-    tensor148, kernel148, inter_result148, result148,      // addresses
+    tiled_matmul_residual_compare(64, 2048, 512,    // dimensions
+    tensor148, kernel148, NULL, &residual148, result148,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_148");
     // verbose(148,tensor148,kernel148,result148)
@@ -2830,15 +2766,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel150[4608][512] row_align(1)= {0};
     static elem_t tensor150[64][4608] row_align(1)= {0};
     static elem_t result150[64][512] row_align(1)= {0};
-    tensor_reshape(512,result149,7, 7, 3, 1, tensor150);
 
 
     /* matmul number: 150 */
 
-    tiled_matmul_compare(64, 512, 4608,    // dimensions
-    tensor150, kernel150, NULL, result150,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_150");
+    conv3x3_compare(7, 512, 64, 512, 4608,    // dimensions
+    result149, tensor150, kernel150, result150,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_150");
     // verbose(150,tensor150,kernel150,result150)
     /* end of matmul number: 150 */
 
@@ -2848,14 +2783,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel151[512][2048] row_align(1)= {0};
     static elem_t tensor151[64][512] row_align(1)= {0};
     static elem_t result151[64][2048] row_align(1)= {0};
-    static elem_t inter_result151[64][2048] row_align(1)= {0};
-    rocket_zeropad(64,512,result149,2048,  inter_result151);
+    const struct tiled_matmul_residual_t residual151 = {&result149[0][0], 512, 512, 0};
 
 
     /* matmul number: 151 */
 
-    tiled_matmul_compare(64, 2048, 512,    // dimensions
-    tensor151, kernel151, inter_result151, result151,      // addresses
+    tiled_matmul_residual_compare(64, 2048, 512,    // dimensions
+    tensor151, kernel151, NULL, &residual151, result151,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_151");
     // verbose(151,tensor151,kernel151,result151)
@@ -2869,7 +2803,7 @@ int main (int argc, char * argv[]) {
     /* AVG Pool: 152 */
 
     static elem_t tensor153[64][2048] row_align(1)= {0};
-    avg_pool7(2048,result151,tensor153);
+    tiled_global_avg_pool(1, 7*7, 2048, &result151[0][0], &tensor153[0][0], 0, tiled_matmul_type);
     end = read_cycles();
     cycles[152] = end-start;
     start = end;
@@ -11,38 +11,13 @@
 #define N 224
 
 
-static void tensor_reshape(int channels, elem_t in_tensor[][channels],int dim1,int dim2,int kdim, int stride, elem_t out_tensor[][channels]){
-    int w1,w2,channel,i,j;
-    int k = 0;
-    int row = 0;
-    for (w1=0;w1<dim1;w1+=stride){
-        for(w2=0;w2<dim2;w2+=stride){
-            k=0;
-            for(channel = 0; channel<channels; channel++){
-                for(i=-kdim/2;i<=kdim/2;i++){
-                    for(j=-kdim/2;j<=kdim/2;j++){
-                        if(i+w1<0 || i+w1>=dim1||j+w2<0 ||j+w2>=dim2)
-                            out_tensor[row][k]=0;
-                        else
-                            out_tensor[row][k]=in_tensor[dim2*(i+w1)+j+w2][channel];
-                        k++;
-                    }
-                }
-            }
-            row++; 
-        }
-    }
-}    
-static void avg_pool7(int len, elem_t in[][len],elem_t out[][len]){
-    int i, j;
-    for(i=0;i<len;i++){
-        for(j=0;j<7*7;j++){
-            out[0][i] += in[j][i];
-        }
-        out[0][i]=out[0][i]/49;
-    }
+// Builds the patch matrix of a conv with 'same' padding on an NHWC activation,
+// with patch rows out_row_len elements apart. The columns are in (kernel row,
+// kernel col, channel) order, so the kernels are laid out like tiled_conv's.
+static void tensor_reshape(int channels, elem_t in_tensor[][channels],int dim1,int dim2,int kdim, int stride, int out_row_len, elem_t out_tensor[][out_row_len]){
+    im2col_nhwc(1, channels, dim1, (dim1+stride-1)/stride, stride, kdim/2, kdim,
+        (void*)in_tensor, out_row_len, out_tensor);
 }
-
 static void rocket_fix_strided_dimension(int img_dim, int len2, elem_t in[][len2], int len3, elem_t out[][len3]){
         
     for(int i =0;i<img_dim;i+=2){
@@ -54,10 +29,29 @@ static void rocket_fix_strided_dimension(int img_dim, int len2, elem_t in[][len2
     }
 }
 
-static void rocket_zeropad(int dim1,int dim2, elem_t in[][dim2], int dim3, elem_t out[][dim3]){
-    for(int i = 0; i<dim1;i++){
-        for(int j =0; j<dim2;j++){
-            out[i][j] = in[i][j];
+// The shortcut of a residual block is added to the output of its last conv
+// inside the accumulator. A shortcut with fewer channels than the output only
+// adds to the first channels, so it doesn't need to be zero-padded first.
+static void tiled_matmul_residual_compare(size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J], void * D,
+        const struct tiled_matmul_residual_t * res,
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift, int relu6_shift, int full_bias_width,
+        enum tiled_matmul_type_t tiled_matmul_type,
+        bool compare, char * layer_name)
+{
+    if (compare)
+        printf("%s: gemmini\n", layer_name);
+    tiled_matmul_residual(DIM_I, DIM_J, DIM_K,
+        A, B, D, res, C, act, shift, relu6_shift, full_bias_width,
+        tiled_matmul_type);
+
+    if (compare) {
+        printf("%s: verifying\n", layer_name);
+        if (!tiled_matmul_verify(DIM_I, DIM_J, DIM_K,
+                A, B, D, res, C, act, shift, relu6_shift, full_bias_width)) {
+            printf("Layer calculated incorrectly: %s\n", layer_name);
+            exit(1);
         }
     }
 }
@@ -70,25 +64,53 @@ static void tiled_matmul_compare(size_t DIM_I, size_t DIM_J, size_t DIM_K,
         enum tiled_matmul_type_t tiled_matmul_type,
         bool compare, char * layer_name)
 {
-    if (compare)
-        printf("%s: gemmini\n", layer_name);
-    tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-        A, B, D, C, act, shift, relu6_shift, full_bias_width,
-        tiled_matmul_type);
+    tiled_matmul_residual_compare(DIM_I, DIM_J, DIM_K, A, B, D, NULL, C,
+        act, shift, relu6_shift, full_bias_width, tiled_matmul_type,
+        compare, layer_name);
+}
+
+// Runs a 3x3 conv with a stride of 1. With winograd, it's run with
+// tiled_conv_winograd, as long as its weights' transform fits in an elem_t
+// and its channels fit in the Winograd buffers, and with compare, it's then
+// checked to be within the Winograd tolerance of the exact conv. Otherwise,
+// it's a matmul on its patch matrix.
+static void conv3x3_compare(size_t img_dim, size_t channels,
+        size_t DIM_I, size_t DIM_J, size_t DIM_K,
+        elem_t in[][channels], elem_t A[DIM_I][DIM_K], elem_t B[DIM_K][DIM_J],
+        elem_t C[DIM_I][DIM_J],
+        int act, int shift,
+        enum tiled_matmul_type_t tiled_matmul_type,
+        bool winograd, bool compare, char * layer_name)
+{
+    static elem_t U[16*512*512] row_align(1);
+
+    const bool transformed = winograd &&
+        winograd_transform_weights(channels, DIM_J, B, (void*)U);
+
+    if (transformed && compare)
+        printf("%s: winograd\n", layer_name);
+
+    if (!transformed || !tiled_conv_winograd(1, img_dim, channels, DIM_J,
+            (void*)in, (void*)U, NULL, C, act, shift, 0, tiled_matmul_type)) {
+        tensor_reshape(channels, in, img_dim, img_dim, 3, 1, DIM_K, A);
+        tiled_matmul_compare(DIM_I, DIM_J, DIM_K, A, B, NULL, C,
+            act, shift, 0, 0, tiled_matmul_type, compare, layer_name);
+        return;
+    }
 
     if (compare) {
         printf("%s: CPU\n", layer_name);
         elem_t gold[DIM_I][DIM_J];
-        tiled_matmul_option(DIM_I, DIM_J, DIM_K,
-            A, B, D, gold, act, shift, relu6_shift, full_bias_width,
-            CPU);
+        tensor_reshape(channels, in, img_dim, img_dim, 3, 1, DIM_K, A);
+        tiled_matmul_option(DIM_I, DIM_J, DIM_K, A, B, NULL, gold,
+            act, shift, 0, 0, CPU);
 
-        if (!MAT_IS_EQUAL(DIM_I, DIM_J, C, gold)) {
+        if (!winograd_within_tolerance(img_dim*img_dim*DIM_J, &C[0][0], &gold[0][0])) {
             printf("Layer calculated incorrectly: %s\n", layer_name);
             exit(1);
         }
     }
-}   
+}
 
 int main (int argc, char * argv[]) {
 #ifndef BAREMETAL
@@ -102,7 +124,7 @@ int main (int argc, char * argv[]) {
 
     enum tiled_matmul_type_t tiled_matmul_type;
     if (argc < 2) {
-        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', or cpu'\n");
+        // printf("usage: %s matmul_option\n  matmul_option may be 'os', 'ws', 'cpu', 'auto', or 'hybrid'\n");
         // exit(0);
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "cpu") == 0) {
@@ -111,16 +133,22 @@ int main (int argc, char * argv[]) {
         tiled_matmul_type = OS;
     } else if (strcmp(argv[1], "ws") == 0) {
         tiled_matmul_type = WS;
+    } else if (strcmp(argv[1], "auto") == 0) {
+        tiled_matmul_type = AUTO;
+    } else if (strcmp(argv[1], "hybrid") == 0) {
+        tiled_matmul_type = HYBRID;
     }
 
-    bool compare;
-    if (argc < 3) {
-        compare = false;
-    } else if (strcmp(argv[2], "compare") == 0) {
-        compare = true;
-    } else {
-        printf("Unknown command-line argument\n");
-        exit(1);
+    bool compare = false, winograd = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "compare") == 0) {
+            compare = true;
+        } else if (strcmp(argv[i], "winograd") == 0) {
+            winograd = true;
+        } else {
+            printf("Unknown command-line argument\n");
+            exit(1);
+        }
     }
 
 
@@ -131,7 +159,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel0[192][64] row_align(1)= {0};
     static elem_t tensor0[12544][192] row_align(1)= {0};
     static elem_t result0[12544][64] row_align(1)= {0};
-    tensor_reshape(3,img,224, 224, 7, 2, tensor0);
+    tensor_reshape(3,img,224, 224, 7, 2, LEN(tensor0[0]), tensor0);
 
 
     /* matmul number: 0 */
@@ -149,7 +177,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel1[576][64] row_align(1)= {0};
     static elem_t tensor1[3136][576] row_align(1)= {0};
     static elem_t result1[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result0,112, 112, 3, 2, tensor1);
+    tensor_reshape(64,result0,112, 112, 3, 2, LEN(tensor1[0]), tensor1);
 
 
     /* matmul number: 1 */
@@ -184,15 +212,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel3[576][64] row_align(1)= {0};
     static elem_t tensor3[3136][576] row_align(1)= {0};
     static elem_t result3[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result2,56, 56, 3, 1, tensor3);
 
 
     /* matmul number: 3 */
 
-    tiled_matmul_compare(3136, 64, 576,    // dimensions
-    tensor3, kernel3, NULL, result3,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_3");
+    conv3x3_compare(56, 64, 3136, 64, 576,    // dimensions
+    result2, tensor3, kernel3, result3,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_3");
     // verbose(3,tensor3,kernel3,result3)
     /* end of matmul number: 3 */
 
@@ -202,14 +229,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel4[64][256] row_align(1)= {0};
     static elem_t tensor4[3136][64] row_align(1)= {0};
     static elem_t result4[3136][256] row_align(1)= {0};
-    static elem_t inter_result4[3136][256] row_align(1)= {0};
-    rocket_zeropad(3136,64,result2,256,  inter_result4);
+    const struct tiled_matmul_residual_t residual4 = {&result2[0][0], 64, 64, 0};
 
 
     /* matmul number: 4 */
 
-    tiled_matmul_compare(3136, 256, 64,    // dimensions
-    tensor4, kernel4, inter_result4, result4,      // addresses
+    tiled_matmul_residual_compare(3136, 256, 64,    // dimensions
+    tensor4, kernel4, NULL, &residual4, result4,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_4");
     // verbose(4,tensor4,kernel4,result4)
@@ -238,15 +264,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel6[576][64] row_align(1)= {0};
     static elem_t tensor6[3136][576] row_align(1)= {0};
     static elem_t result6[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result5,56, 56, 3, 1, tensor6);
 
 
     /* matmul number: 6 */
 
-    tiled_matmul_compare(3136, 64, 576,    // dimensions
-    tensor6, kernel6, NULL, result6,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_6");
+    conv3x3_compare(56, 64, 3136, 64, 576,    // dimensions
+    result5, tensor6, kernel6, result6,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_6");
     // verbose(6,tensor6,kernel6,result6)
     /* end of matmul number: 6 */
 
@@ -256,14 +281,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel7[64][256] row_align(1)= {0};
     static elem_t tensor7[3136][64] row_align(1)= {0};
     static elem_t result7[3136][256] row_align(1)= {0};
-    static elem_t inter_result7[3136][256] row_align(1)= {0};
-    rocket_zeropad(3136,64,result5,256,  inter_result7);
+    const struct tiled_matmul_residual_t residual7 = {&result5[0][0], 64, 64, 0};
 
 
     /* matmul number: 7 */
 
-    tiled_matmul_compare(3136, 256, 64,    // dimensions
-    tensor7, kernel7, inter_result7, result7,      // addresses
+    tiled_matmul_residual_compare(3136, 256, 64,    // dimensions
+    tensor7, kernel7, NULL, &residual7, result7,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_7");
     // verbose(7,tensor7,kernel7,result7)
@@ -292,15 +316,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel9[576][64] row_align(1)= {0};
     static elem_t tensor9[3136][576] row_align(1)= {0};
     static elem_t result9[3136][64] row_align(1)= {0};
-    tensor_reshape(64,result8,56, 56, 3, 1, tensor9);
 
 
     /* matmul number: 9 */
 
-    tiled_matmul_compare(3136, 64, 576,    // dimensions
-    tensor9, kernel9, NULL, result9,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_9");
+    conv3x3_compare(56, 64, 3136, 64, 576,    // dimensions
+    result8, tensor9, kernel9, result9,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_9");
     // verbose(9,tensor9,kernel9,result9)
     /* end of matmul number: 9 */
 
@@ -310,14 +333,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel10[64][256] row_align(1)= {0};
     static elem_t tensor10[3136][64] row_align(1)= {0};
     static elem_t result10[3136][256] row_align(1)= {0};
-    static elem_t inter_result10[3136][256] row_align(1)= {0};
-    rocket_zeropad(3136,64,result8,256,  inter_result10);
+    const struct tiled_matmul_residual_t residual10 = {&result8[0][0], 64, 64, 0};
 
 
     /* matmul number: 10 */
 
-    tiled_matmul_compare(3136, 256, 64,    // dimensions
-    tensor10, kernel10, inter_result10, result10,      // addresses
+    tiled_matmul_residual_compare(3136, 256, 64,    // dimensions
+    tensor10, kernel10, NULL, &residual10, result10,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_10");
     // verbose(10,tensor10,kernel10,result10)
@@ -346,7 +368,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel12[1152][128] row_align(1)= {0};
     static elem_t tensor12[832][1152] row_align(1)= {0};
     static elem_t result12[832][128] row_align(1)= {0};
-    tensor_reshape(128,result11,56, 56, 3, 2, tensor12);
+    tensor_reshape(128,result11,56, 56, 3, 2, LEN(tensor12[0]), tensor12);
 
 
     /* matmul number: 12 */
@@ -400,15 +422,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel15[1152][128] row_align(1)= {0};
     static elem_t tensor15[832][1152] row_align(1)= {0};
     static elem_t result15[832][128] row_align(1)= {0};
-    tensor_reshape(128,result14,28, 28, 3, 1, tensor15);
 
 
     /* matmul number: 15 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor15, kernel15, NULL, result15,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_15");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result14, tensor15, kernel15, result15,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_15");
     // verbose(15,tensor15,kernel15,result15)
     /* end of matmul number: 15 */
 
@@ -418,14 +439,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel16[128][512] row_align(1)= {0};
     static elem_t tensor16[832][128] row_align(1)= {0};
     static elem_t result16[832][512] row_align(1)= {0};
-    static elem_t inter_result16[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result14,512,  inter_result16);
+    const struct tiled_matmul_residual_t residual16 = {&result14[0][0], 128, 128, 0};
 
 
     /* matmul number: 16 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor16, kernel16, inter_result16, result16,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor16, kernel16, NULL, &residual16, result16,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_16");
     // verbose(16,tensor16,kernel16,result16)
@@ -454,15 +474,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel18[1152][128] row_align(1)= {0};
     static elem_t tensor18[832][1152] row_align(1)= {0};
     static elem_t result18[832][128] row_align(1)= {0};
-    tensor_reshape(128,result17,28, 28, 3, 1, tensor18);
 
 
     /* matmul number: 18 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor18, kernel18, NULL, result18,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_18");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result17, tensor18, kernel18, result18,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_18");
     // verbose(18,tensor18,kernel18,result18)
     /* end of matmul number: 18 */
 
@@ -472,14 +491,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel19[128][512] row_align(1)= {0};
     static elem_t tensor19[832][128] row_align(1)= {0};
     static elem_t result19[832][512] row_align(1)= {0};
-    static elem_t inter_result19[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result17,512,  inter_result19);
+    const struct tiled_matmul_residual_t residual19 = {&result17[0][0], 128, 128, 0};
 
 
     /* matmul number: 19 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor19, kernel19, inter_result19, result19,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor19, kernel19, NULL, &residual19, result19,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_19");
     // verbose(19,tensor19,kernel19,result19)
@@ -508,15 +526,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel21[1152][128] row_align(1)= {0};
     static elem_t tensor21[832][1152] row_align(1)= {0};
     static elem_t result21[832][128] row_align(1)= {0};
-    tensor_reshape(128,result20,28, 28, 3, 1, tensor21);
 
 
     /* matmul number: 21 */
 
-    tiled_matmul_compare(832, 128, 1152,    // dimensions
-    tensor21, kernel21, NULL, result21,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_21");
+    conv3x3_compare(28, 128, 832, 128, 1152,    // dimensions
+    result20, tensor21, kernel21, result21,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_21");
     // verbose(21,tensor21,kernel21,result21)
     /* end of matmul number: 21 */
 
@@ -526,14 +543,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel22[128][512] row_align(1)= {0};
     static elem_t tensor22[832][128] row_align(1)= {0};
     static elem_t result22[832][512] row_align(1)= {0};
-    static elem_t inter_result22[832][512] row_align(1)= {0};
-    rocket_zeropad(832,128,result20,512,  inter_result22);
+    const struct tiled_matmul_residual_t residual22 = {&result20[0][0], 128, 128, 0};
 
 
     /* matmul number: 22 */
 
-    tiled_matmul_compare(832, 512, 128,    // dimensions
-    tensor22, kernel22, inter_result22, result22,      // addresses
+    tiled_matmul_residual_compare(832, 512, 128,    // dimensions
+    tensor22, kernel22, NULL, &residual22, result22,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_22");
     // verbose(22,tensor22,kernel22,result22)
@@ -562,7 +578,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel24[2304][256] row_align(1)= {0};
     static elem_t tensor24[256][2304] row_align(1)= {0};
     static elem_t result24[256][256] row_align(1)= {0};
-    tensor_reshape(256,result23,28, 28, 3, 2, tensor24);
+    tensor_reshape(256,result23,28, 28, 3, 2, LEN(tensor24[0]), tensor24);
 
 
     /* matmul number: 24 */
@@ -616,15 +632,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel27[2304][256] row_align(1)= {0};
     static elem_t tensor27[256][2304] row_align(1)= {0};
     static elem_t result27[256][256] row_align(1)= {0};
-    tensor_reshape(256,result26,14, 14, 3, 1, tensor27);
 
 
     /* matmul number: 27 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor27, kernel27, NULL, result27,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_27");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result26, tensor27, kernel27, result27,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_27");
     // verbose(27,tensor27,kernel27,result27)
     /* end of matmul number: 27 */
 
@@ -634,14 +649,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel28[256][1024] row_align(1)= {0};
     static elem_t tensor28[256][256] row_align(1)= {0};
     static elem_t result28[256][1024] row_align(1)= {0};
-    static elem_t inter_result28[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result26,1024,  inter_result28);
+    const struct tiled_matmul_residual_t residual28 = {&result26[0][0], 256, 256, 0};
 
 
     /* matmul number: 28 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor28, kernel28, inter_result28, result28,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor28, kernel28, NULL, &residual28, result28,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_28");
     // verbose(28,tensor28,kernel28,result28)
@@ -670,15 +684,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel30[2304][256] row_align(1)= {0};
     static elem_t tensor30[256][2304] row_align(1)= {0};
     static elem_t result30[256][256] row_align(1)= {0};
-    tensor_reshape(256,result29,14, 14, 3, 1, tensor30);
 
 
     /* matmul number: 30 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor30, kernel30, NULL, result30,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_30");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result29, tensor30, kernel30, result30,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_30");
     // verbose(30,tensor30,kernel30,result30)
     /* end of matmul number: 30 */
 
@@ -688,14 +701,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel31[256][1024] row_align(1)= {0};
     static elem_t tensor31[256][256] row_align(1)= {0};
     static elem_t result31[256][1024] row_align(1)= {0};
-    static elem_t inter_result31[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result29,1024,  inter_result31);
+    const struct tiled_matmul_residual_t residual31 = {&result29[0][0], 256, 256, 0};
 
 
     /* matmul number: 31 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor31, kernel31, inter_result31, result31,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor31, kernel31, NULL, &residual31, result31,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_31");
     // verbose(31,tensor31,kernel31,result31)
@@ -724,15 +736,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel33[2304][256] row_align(1)= {0};
     static elem_t tensor33[256][2304] row_align(1)= {0};
     static elem_t result33[256][256] row_align(1)= {0};
-    tensor_reshape(256,result32,14, 14, 3, 1, tensor33);
 
 
     /* matmul number: 33 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor33, kernel33, NULL, result33,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_33");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result32, tensor33, kernel33, result33,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_33");
     // verbose(33,tensor33,kernel33,result33)
     /* end of matmul number: 33 */
 
@@ -742,14 +753,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel34[256][1024] row_align(1)= {0};
     static elem_t tensor34[256][256] row_align(1)= {0};
     static elem_t result34[256][1024] row_align(1)= {0};
-    static elem_t inter_result34[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result32,1024,  inter_result34);
+    const struct tiled_matmul_residual_t residual34 = {&result32[0][0], 256, 256, 0};
 
 
     /* matmul number: 34 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor34, kernel34, inter_result34, result34,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor34, kernel34, NULL, &residual34, result34,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_34");
     // verbose(34,tensor34,kernel34,result34)
@@ -778,15 +788,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel36[2304][256] row_align(1)= {0};
     static elem_t tensor36[256][2304] row_align(1)= {0};
     static elem_t result36[256][256] row_align(1)= {0};
-    tensor_reshape(256,result35,14, 14, 3, 1, tensor36);
 
 
     /* matmul number: 36 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor36, kernel36, NULL, result36,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_36");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result35, tensor36, kernel36, result36,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_36");
     // verbose(36,tensor36,kernel36,result36)
     /* end of matmul number: 36 */
 
@@ -796,14 +805,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel37[256][1024] row_align(1)= {0};
     static elem_t tensor37[256][256] row_align(1)= {0};
     static elem_t result37[256][1024] row_align(1)= {0};
-    static elem_t inter_result37[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result35,1024,  inter_result37);
+    const struct tiled_matmul_residual_t residual37 = {&result35[0][0], 256, 256, 0};
 
 
     /* matmul number: 37 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor37, kernel37, inter_result37, result37,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor37, kernel37, NULL, &residual37, result37,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_37");
     // verbose(37,tensor37,kernel37,result37)
@@ -832,15 +840,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel39[2304][256] row_align(1)= {0};
     static elem_t tensor39[256][2304] row_align(1)= {0};
     static elem_t result39[256][256] row_align(1)= {0};
-    tensor_reshape(256,result38,14, 14, 3, 1, tensor39);
 
 
     /* matmul number: 39 */
 
-    tiled_matmul_compare(256, 256, 2304,    // dimensions
-    tensor39, kernel39, NULL, result39,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_39");
+    conv3x3_compare(14, 256, 256, 256, 2304,    // dimensions
+    result38, tensor39, kernel39, result39,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_39");
     // verbose(39,tensor39,kernel39,result39)
     /* end of matmul number: 39 */
 
@@ -850,14 +857,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel40[256][1024] row_align(1)= {0};
     static elem_t tensor40[256][256] row_align(1)= {0};
     static elem_t result40[256][1024] row_align(1)= {0};
-    static elem_t inter_result40[256][1024] row_align(1)= {0};
-    rocket_zeropad(256,256,result38,1024,  inter_result40);
+    const struct tiled_matmul_residual_t residual40 = {&result38[0][0], 256, 256, 0};
 
 
     /* matmul number: 40 */
 
-    tiled_matmul_compare(256, 1024, 256,    // dimensions
-    tensor40, kernel40, inter_result40, result40,      // addresses
+    tiled_matmul_residual_compare(256, 1024, 256,    // dimensions
+    tensor40, kernel40, NULL, &residual40, result40,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_40");
     // verbose(40,tensor40,kernel40,result40)
@@ -886,7 +892,7 @@ int main (int argc, char * argv[]) {
     static elem_t kernel42[4608][512] row_align(1)= {0};
     static elem_t tensor42[64][4608] row_align(1)= {0};
     static elem_t result42[64][512] row_align(1)= {0};
-    tensor_reshape(512,result41,14, 14, 3, 2, tensor42);
+    tensor_reshape(512,result41,14, 14, 3, 2, LEN(tensor42[0]), tensor42);
 
 
     /* matmul number: 42 */
@@ -940,15 +946,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel45[4608][512] row_align(1)= {0};
     static elem_t tensor45[64][4608] row_align(1)= {0};
     static elem_t result45[64][512] row_align(1)= {0};
-    tensor_reshape(512,result44,7, 7, 3, 1, tensor45);
 
 
     /* matmul number: 45 */
 
-    tiled_matmul_compare(64, 512, 4608,    // dimensions
-    tensor45, kernel45, NULL, result45,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_45");
+    conv3x3_compare(7, 512, 64, 512, 4608,    // dimensions
+    result44, tensor45, kernel45, result45,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_45");
     // verbose(45,tensor45,kernel45,result45)
     /* end of matmul number: 45 */
 
@@ -958,14 +963,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel46[512][2048] row_align(1)= {0};
     static elem_t tensor46[64][512] row_align(1)= {0};
     static elem_t result46[64][2048] row_align(1)= {0};
-    static elem_t inter_result46[64][2048] row_align(1)= {0};
-    rocket_zeropad(64,512,result44,2048,  inter_result46);
+    const struct tiled_matmul_residual_t residual46 = {&result44[0][0], 512, 512, 0};
 
 
     /* matmul number: 46 */
 
-    tiled_matmul_compare(64, 2048, 512,    // dimensions
-    tensor46, kernel46, inter_result46, result46,      // addresses
+    tiled_matmul_residual_compare(64, 2048, 512,    // dimensions
+    tensor46, kernel46, NULL, &residual46, result46,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_46");
     // verbose(46,tensor46,kernel46,result46)
@@ -994,15 +998,14 @@ int main (int argc, char * argv[]) {
     static elem_t kernel48[4608][512] row_align(1)= {0};
     static elem_t tensor48[64][4608] row_align(1)= {0};
     static elem_t result48[64][512] row_align(1)= {0};
-    tensor_reshape(512,result47,7, 7, 3, 1, tensor48);
 
 
     /* matmul number: 48 */
 
-    tiled_matmul_compare(64, 512, 4608,    // dimensions
-    tensor48, kernel48, NULL, result48,      // addresses
-    RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
-    tiled_matmul_type, compare, "layer_48");
+    conv3x3_compare(7, 512, 64, 512, 4608,    // dimensions
+    result47, tensor48, kernel48, result48,      // addresses
+    RELU, 0,              // activation, shift
+    tiled_matmul_type, winograd, compare, "layer_48");
     // verbose(48,tensor48,kernel48,result48)
     /* end of matmul number: 48 */
 
@@ -1012,14 +1015,13 @@ int main (int argc, char * argv[]) {
     static elem_t kernel49[512][2048] row_align(1)= {0};
     static elem_t tensor49[64][512] row_align(1)= {0};
     static elem_t result49[64][2048] row_align(1)= {0};
-    static elem_t inter_result49[64][2048] row_align(1)= {0};
-    rocket_zeropad(64,512,result47,2048,  inter_result49);
+    const struct tiled_matmul_residual_t residual49 = {&result47[0][0], 512, 512, 0};
 
 
     /* matmul number: 49 */
 
-    tiled_matmul_compare(64, 2048, 512,    // dimensions
-    tensor49, kernel49, inter_result49, result49,      // addresses
+    tiled_matmul_residual_compare(64, 2048, 512,    // dimensions
+    tensor49, kernel49, NULL, &residual49, result49,      // addresses
     RELU, 0, 0, 0,              // activation, shift, r6_shift, full_width_bias
     tiled_matmul_type, compare, "layer_49");
     // verbose(49,tensor49,kernel49,result49)
@@ -1033,7 +1035,7 @@ int main (int argc, char * argv[]) {
     /* AVG Pool: 50 */
 
     static elem_t tensor51[64][2048] row_align(1)= {0};
-    avg_pool7(2048,result49,tensor51);
+    tiled_global_avg_pool(1, 7*7, 2048, &result49[0][0], &tensor51[0][0], 0, tiled_matmul_type);
     end = read_cycles();
     cycles[50] = end-start;
     start = end;